@@ -0,0 +1,207 @@
+// stdx::scan kernels on long strings: scalar loops against the SSE2 and
+// AVX2 tiers, after checking that every tier returns the same results.
+//
+//   g++ -O2 -std=c++17 -I.. scan_kernels.cpp -o scan_kernels
+//   cl /O2 /std:c++17 /EHsc /I.. scan_kernels.cpp
+//
+// Without -mavx2 (or /arch:AVX2) the AVX2 tier is reached through the
+// runtime dispatch; scan::allow_avx2(false) pins the SSE2 one. The scalar
+// column is the plain loop each kernel replaced; byte-wide find is memchr
+// in both SIMD columns. Exits non-zero if any tier disagrees with the
+// scalar result.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../stdxscan.h"
+
+using namespace stdx;
+
+static int failures = 0;
+
+//============================
+// Scalar references
+//============================
+namespace ref {
+    template<typename Unit>
+    size_t find(const Unit* p, size_t n, char32_t c, size_t from) {
+        for (size_t i = from; i < n; ++i) {
+            if (p[i] == c) return i;
+        }
+        return scan::npos;
+    }
+
+    template<typename Unit>
+    size_t rfind(const Unit* p, size_t n, char32_t c) {
+        while (n-- > 0) {
+            if (p[n] == c) return n;
+        }
+        return scan::npos;
+    }
+
+    template<typename Unit>
+    size_t count(const Unit* p, size_t n, char32_t c) {
+        size_t hits = 0;
+        for (size_t i = 0; i < n; ++i) hits += p[i] == c;
+        return hits;
+    }
+
+    template<typename Unit>
+    size_t replace(Unit* p, size_t n, char32_t from, char32_t to) {
+        size_t hits = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (p[i] == from) { p[i] = (Unit)to; ++hits; }
+        }
+        return hits;
+    }
+
+    template<typename Unit>
+    size_t find_set(const Unit* p, size_t n, const scan::small_set& set, size_t from, bool in) {
+        for (size_t i = from; i < n; ++i) {
+            if (set.contains(p[i]) == in) return i;
+        }
+        return scan::npos;
+    }
+
+    template<typename Unit>
+    size_t rfind_not(const Unit* p, size_t n, const scan::small_set& set) {
+        while (n-- > 0) {
+            if (!set.contains(p[n])) return n;
+        }
+        return scan::npos;
+    }
+
+    template<typename Unit>
+    size_t mismatch(const Unit* a, const Unit* b, size_t n) {
+        size_t i = 0;
+        while (i < n && a[i] == b[i]) ++i;
+        return i;
+    }
+}
+
+static const scan::small_set separators = { { U',', U';', U'|', U'\t' }, 4 };
+
+//============================
+// Equality against the scalar loops
+//============================
+template<typename Unit>
+static void expect(const char* kernel, const char* tier, size_t n, size_t got, size_t want) {
+    if (got == want) return;
+    if (++failures <= 20) printf("MISMATCH %s<%zu> %s n=%zu: %zu, expected %zu\n", kernel, sizeof(Unit), tier, n, got, want);
+}
+
+// Lengths around every block size, offsets that misalign the start, and
+// matches at the edges of blocks.
+template<typename Unit>
+static void verify(const char* tier) {
+    std::mt19937 rng(42);
+    const char32_t wide = sizeof(Unit) == 1 ? 0xE9 : sizeof(Unit) == 2 ? 0x4E2D : 0x1F600;
+    const char32_t alphabet[] = { U'a', U'b', U' ', U',', U'\t', wide };
+    std::vector<Unit> buf(300 + 64), other;
+
+    for (size_t n = 0; n <= 300; ++n) {
+        for (size_t offset = 0; offset < 4; ++offset) {
+            for (int round = 0; round < 4; ++round) {
+                Unit* p = buf.data() + offset;
+                // round 0: all 'a' plus one hit; later rounds: random text
+                for (size_t i = 0; i < n; ++i) p[i] = (Unit)(round == 0 ? U'a' : alphabet[rng() % 6]);
+                if (round == 0 && n) p[rng() % n] = (Unit)wide;
+                size_t from = n ? rng() % n : 0;
+
+                for (char32_t c : { (char32_t)U'b', wide, (char32_t)U',' }) {
+                    expect<Unit>("find", tier, n, scan::find(p, n, c, from), ref::find(p, n, c, from));
+                    expect<Unit>("rfind", tier, n, scan::rfind(p, n, c), ref::rfind(p, n, c));
+                    expect<Unit>("count", tier, n, scan::count(p, n, c), ref::count(p, n, c));
+                }
+                expect<Unit>("find_any", tier, n, scan::find_any(p, n, separators, from), ref::find_set(p, n, separators, from, true));
+                expect<Unit>("find_not", tier, n, scan::find_not(p, n, scan::trim_spaces, from), ref::find_set(p, n, scan::trim_spaces, from, false));
+                expect<Unit>("rfind_not", tier, n, scan::rfind_not(p, n, scan::trim_spaces), ref::rfind_not(p, n, scan::trim_spaces));
+
+                other.assign(p, p + n);
+                if (n && round) other[rng() % n] = (Unit)U'z';
+                expect<Unit>("mismatch", tier, n, scan::mismatch(p, other.data(), n), ref::mismatch(p, other.data(), n));
+
+                other.assign(p, p + n);
+                size_t hits = scan::replace(p, n, U'a', U'x');
+                expect<Unit>("replace", tier, n, hits, ref::replace(other.data(), n, U'a', U'x'));
+                for (size_t i = 0; i < n; ++i) {
+                    if (p[i] != other[i]) { expect<Unit>("replace (contents)", tier, n, i, scan::npos); break; }
+                }
+            }
+        }
+    }
+}
+
+//============================
+// Timing
+//============================
+static const size_t length = 64 * 1024;
+static const int passes = 2000;
+
+// Read through a volatile each pass, so no call can be hoisted out of the
+// loop (memchr, for one, is known to be pure).
+static volatile size_t g_length = length;
+static size_t n() { return g_length; }
+
+template<typename F>
+static double time_ms(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    size_t sink = 0;
+    for (int i = 0; i < passes; ++i) sink += f();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 12345) printf(" ");
+    return ms;
+}
+
+// The scalar column, then the dispatched kernel with AVX2 off and on.
+template<typename Scalar, typename Kernel>
+static void row(const char* name, Scalar&& scalar, Kernel&& kernel) {
+    double s = time_ms(scalar);
+    scan::allow_avx2(false);
+    double sse2 = time_ms(kernel);
+    scan::allow_avx2(true);
+    double avx2 = time_ms(kernel);
+    printf("  %-10s %8.1f %8.1f %8.1f ms\n", name, s, sse2, avx2);
+}
+
+// Each case scans the whole string: the match, if any, is in the last unit.
+template<typename Unit>
+static void bench() {
+    printf("%zu-byte units, %zu units x %d passes      scalar     sse2     avx2\n", sizeof(Unit), length, passes);
+    std::vector<Unit> text(length, (Unit)U'a'), same(text), spaces(length, (Unit)U' ');
+    text.back() = (Unit)U',';
+    same.back() = (Unit)U'b';
+    spaces[0] = (Unit)U'x';
+    spaces.back() = (Unit)U'x';
+    const Unit* p = text.data();
+
+    row("find", [&] { return ref::find(p, n(), U',', 0); }, [&] { return scan::find(p, n(), U',', 0); });
+    row("rfind", [&] { return ref::rfind(p + 1, n() - 1, U'a' + 1); }, [&] { return scan::rfind(p + 1, n() - 1, U'a' + 1); });
+    row("count", [&] { return ref::count(p, n(), U','); }, [&] { return scan::count(p, n(), U','); });
+    row("replace", [&] { return ref::replace(text.data(), n(), U'z', U'y'); }, [&] { return scan::replace(text.data(), n(), U'z', U'y'); });
+    row("find_any", [&] { return ref::find_set(p, n(), separators, 0, true); }, [&] { return scan::find_any(p, n(), separators); });
+    row("find_not", [&] { return ref::find_set(spaces.data(), n(), scan::trim_spaces, 1, false); }, [&] { return scan::find_not(spaces.data(), n(), scan::trim_spaces, 1); });
+    row("rfind_not", [&] { return ref::rfind_not(spaces.data(), n() - 1, scan::trim_spaces); }, [&] { return scan::rfind_not(spaces.data(), n() - 1, scan::trim_spaces); });
+    row("mismatch", [&] { return ref::mismatch(p, same.data(), n()); }, [&] { return scan::mismatch(p, same.data(), n()); });
+}
+
+int main() {
+    bool avx2 = scan::uses_avx2();
+    printf("AVX2 kernels: %s\n", avx2 ? "available" : "not available (the avx2 column repeats sse2)");
+
+    const char* tiers[] = { "sse2", "avx2" };
+    for (int t = 0; t < (avx2 ? 2 : 1); ++t) {
+        scan::allow_avx2(t == 1);
+        verify<unsigned char>(tiers[t]);
+        verify<char16_t>(tiers[t]);
+        verify<char32_t>(tiers[t]);
+    }
+    scan::allow_avx2(true);
+    printf("equality against scalar loops: %s\n\n", failures ? "FAILED" : "ok");
+
+    bench<unsigned char>();
+    bench<char16_t>();
+    bench<char32_t>();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+// Allocation counts for split/join workloads on stdx::string.
+//
+//   g++ -O2 -std=c++17 -I.. split_join_alloc.cpp -o split_join_alloc
+//   cl /O2 /std:c++17 /EHsc /I.. split_join_alloc.cpp
+//
+// Every global operator new is counted. The std::vector<char32_t> rows
+// mimic the storage stdx::string used before the small-string buffer: one
+// heap block per field, however short.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "../stdxstring.h"
+
+static size_t g_allocations = 0;
+
+void* operator new(size_t n) {
+    ++g_allocations;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+static const size_t iterations = 100000;
+
+template<typename F>
+static void run(const char* name, F&& f) {
+    size_t before = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    size_t checksum = 0;
+    for (size_t i = 0; i < iterations; ++i) checksum += f();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("%-36s %6.2f allocs/iter %6lld ms  (%zu)\n", name, (double)(g_allocations - before) / iterations, (long long)ms, checksum);
+}
+
+int main() {
+    const stdx::string line("alpha,beta,gamma,delta,42,3.14,true,2024-01-01,user@example.com,ok");
+    const stdx::string comma(",");
+    const std::u32string wide = U"alpha,beta,gamma,delta,42,3.14,true,2024-01-01,user@example.com,ok";
+
+    run("vector<char32_t> split + join", [&] {
+        std::vector<std::vector<char32_t>> fields;
+        size_t start = 0;
+        for (size_t i = 0; i <= wide.size(); ++i) {
+            if (i == wide.size() || wide[i] == U',') {
+                fields.emplace_back(wide.begin() + start, wide.begin() + i);
+                start = i + 1;
+            }
+        }
+        std::vector<char32_t> joined;
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (i) joined.push_back(U',');
+            joined.insert(joined.end(), fields[i].begin(), fields[i].end());
+        }
+        return joined.size();
+    });
+
+    run("stdx::string split + join", [&] {
+        std::vector<stdx::string> fields = line.split(U',');
+        return stdx::string::join(fields, comma).size();
+    });
+
+    run("stdx::string split", [&] { return line.split(U',').size(); });
+
+    run("string_view split + join", [&] {
+        std::vector<stdx::string_view> fields = line.view().split(U',');
+        return stdx::string::join(fields, comma).size();
+    });
+
+    // reused vector and buffer: steady state allocates nothing
+    std::pmr::monotonic_buffer_resource arena(64 * 1024);
+    std::pmr::vector<stdx::string> reused(&arena);
+    run("pmr split (reused vector)", [&] {
+        line.split(U',', reused);
+        return reused.size();
+    });
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "stdxstring.h"
+
+namespace stdx {
+    namespace detail {
+        // Interned text: this header, then the code points at the narrowest
+        // width that holds them, then a terminator.
+        struct atom_entry {
+            size_t hash;
+            size_t size;
+            size_t width;
+
+            inline const unsigned char* units() const { return (const unsigned char*)(this + 1); }
+        };
+
+        // Bump allocator; memory is only given back when the arena dies.
+        class atom_arena {
+        public:
+            static constexpr size_t chunk_bytes = 64 * 1024;
+
+            inline void* allocate(size_t bytes) {
+                bytes = (bytes + alignof(atom_entry) - 1) & ~(alignof(atom_entry) - 1);
+                if (bytes > m_left) {
+                    size_t size = std::max(bytes, chunk_bytes);
+                    m_chunks.emplace_back(new unsigned char[size]);
+                    m_next = m_chunks.back().get();
+                    m_left = size;
+                }
+                void* p = m_next;
+                m_next += bytes;
+                m_left -= bytes;
+                return p;
+            }
+
+        private:
+            std::vector<std::unique_ptr<unsigned char[]>> m_chunks;
+            unsigned char* m_next = nullptr;
+            size_t m_left = 0;
+        };
+    }
+
+    //============================
+    // atom (handle to an interned string)
+    //============================
+    // Pointer-sized; two atoms from the same table are equal exactly when
+    // their text is, so == and hash() never look at the text. The default
+    // atom is the empty string.
+    class atom {
+    public:
+        atom() = default;
+
+        inline string_view view() const {
+            return m_entry ? string_view(m_entry->units(), m_entry->size, (unsigned)m_entry->width) : string_view();
+        }
+
+        inline size_t size() const { return m_entry ? m_entry->size : 0; }
+        inline bool empty() const { return m_entry == nullptr; }
+        inline stdx::string str() const { return stdx::string(view()); }
+
+        // Same value as the text's stdx::string::hash().
+        inline size_t hash() const { return m_entry ? m_entry->hash : string_view().hash(); }
+
+        operator string_view() const { return view(); }
+
+        inline bool operator==(atom rhs) const { return m_entry == rhs.m_entry; }
+        inline bool operator!=(atom rhs) const { return m_entry != rhs.m_entry; }
+
+    private:
+        friend class atom_table;
+
+        explicit atom(const detail::atom_entry* entry) : m_entry(entry) {}
+
+        const detail::atom_entry* m_entry = nullptr;
+    };
+
+    //============================
+    // atom_table (thread-safe string interning)
+    //============================
+    // Lookups are lock-free: an open-addressed table of atomic entry
+    // pointers, read with acquire loads. Inserts serialize on a mutex,
+    // copy the text into the arena and publish the entry; growing installs
+    // a new table and keeps the old ones alive for readers still probing
+    // them, so nothing a reader can reach is ever freed.
+    class atom_table {
+    public:
+        atom_table() { install(64); }
+
+        atom_table(const atom_table&) = delete;
+        atom_table& operator=(const atom_table&) = delete;
+
+        // A key's cached hash (stdx::string::hash) is an atomic word, so
+        // threads sharing one const key race on nothing but the table.
+        inline atom intern(string_view s) { return intern(s, s.hash()); }
+        inline atom intern(const stdx::string& s) { return intern(s.view(), s.hash()); }
+
+        // Returns the empty atom when s has not been interned.
+        inline atom find(string_view s) const { return atom(lookup(s, s.hash())); }
+        inline atom find(const stdx::string& s) const { return atom(lookup(s.view(), s.hash())); }
+
+        inline size_t size() const { return m_count.load(std::memory_order_relaxed); }
+
+        // Process-wide table behind stdx::intern().
+        static atom_table& global() {
+            static atom_table table;
+            return table;
+        }
+
+    private:
+        using slot = std::atomic<const detail::atom_entry*>;
+
+        struct slots {
+            size_t mask;
+            std::unique_ptr<slot[]> entries;
+        };
+
+        std::atomic<const slots*> m_slots{ nullptr };
+        std::vector<std::unique_ptr<slots>> m_tables; // current one last
+        std::mutex m_lock;
+        detail::atom_arena m_arena;
+        std::atomic<size_t> m_count{ 0 };
+
+        static bool matches(const detail::atom_entry* e, string_view s, size_t hash) {
+            return e->hash == hash && e->size == s.size() &&
+                string_view(e->units(), e->size, (unsigned)e->width) == s;
+        }
+
+        inline const detail::atom_entry* lookup(string_view s, size_t hash) const {
+            if (s.empty()) return nullptr;
+            const slots* t = m_slots.load(std::memory_order_acquire);
+            for (size_t i = hash & t->mask;; i = (i + 1) & t->mask) {
+                const detail::atom_entry* e = t->entries[i].load(std::memory_order_acquire);
+                if (!e) return nullptr;
+                if (matches(e, s, hash)) return e;
+            }
+        }
+
+        inline atom intern(string_view s, size_t hash) {
+            if (const detail::atom_entry* e = lookup(s, hash)) return atom(e);
+            if (s.empty()) return atom();
+
+            std::lock_guard<std::mutex> guard(m_lock);
+            // another thread may have added it, or grown the table, meanwhile
+            if (const detail::atom_entry* e = lookup(s, hash)) return atom(e);
+
+            size_t count = m_count.load(std::memory_order_relaxed);
+            if ((count + 1) * 2 > m_tables.back()->mask + 1) install((m_tables.back()->mask + 1) * 2);
+
+            unsigned width = s.needed_width();
+            auto* e = new (m_arena.allocate(sizeof(detail::atom_entry) + (s.size() + 1) * width)) detail::atom_entry{ hash, s.size(), width };
+            unsigned char* units = (unsigned char*)(e + 1);
+            s.visit([&](const auto* src) {
+                detail::visit_units(units, width, [&](auto* dst) {
+                    detail::copy_units(dst, src, s.size());
+                    dst[s.size()] = 0;
+                });
+            });
+
+            place(*m_tables.back(), e);
+            m_count.store(count + 1, std::memory_order_relaxed);
+            return atom(e);
+        }
+
+        static void place(slots& t, const detail::atom_entry* e) {
+            size_t i = e->hash & t.mask;
+            while (t.entries[i].load(std::memory_order_relaxed)) i = (i + 1) & t.mask;
+            t.entries[i].store(e, std::memory_order_release);
+        }
+
+        // Caller holds m_lock (or is the constructor).
+        inline void install(size_t capacity) {
+            auto t = std::make_unique<slots>();
+            t->mask = capacity - 1;
+            t->entries.reset(new slot[capacity]());
+            if (!m_tables.empty()) {
+                const slots& old = *m_tables.back();
+                for (size_t i = 0; i <= old.mask; ++i) {
+                    if (const detail::atom_entry* e = old.entries[i].load(std::memory_order_relaxed)) place(*t, e);
+                }
+            }
+            m_slots.store(t.get(), std::memory_order_release);
+            m_tables.push_back(std::move(t));
+        }
+    };
+
+    inline atom intern(string_view s) { return atom_table::global().intern(s); }
+    inline atom intern(const stdx::string& s) { return atom_table::global().intern(s); }
+}
+
+namespace std {
+    template<>
+    struct hash<stdx::atom> {
+        inline size_t operator()(stdx::atom a) const { return a.hash(); }
+    };
+}
\ No newline at end of file
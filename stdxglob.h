@@ -0,0 +1,291 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "stdxcase.h"
+#include "stdxstring.h"
+
+namespace stdx {
+    //============================
+    // glob (compiled wildcard pattern)
+    //============================
+    // '*' matches any run of code points, '?' any single one, and [abc],
+    // [a-z] or [!a-z] / [^a-z] one that is (not) in the set. A ']' straight
+    // after the opening '[' or '[!' is a member; a '[' that is never closed
+    // is literal. There is no escape character, so Windows paths keep their
+    // backslashes: write [*], [?] or [[] for those characters.
+    //
+    // The pattern compiles to a bit-parallel automaton (Shift-And, one bit
+    // per pattern position, '*' as a self-loop). Matching reads the text
+    // once, left to right, for O(n * ceil(m / 64)) work whatever the
+    // pattern - no backtracking - and stops as soon as the outcome is known.
+    class glob {
+    public:
+        enum flags : unsigned {
+            none = 0,
+            ignore_case = 1, // simple case folding, as equals_ignore_case
+        };
+
+        // Matches only the empty string.
+        glob() { compile(string_view(), none); }
+
+        explicit glob(string_view pattern, unsigned flags = none) { compile(pattern, flags); }
+        explicit glob(const stdx::string& pattern, unsigned flags = none) { compile(pattern.view(), flags); }
+        explicit glob(const char* pattern, unsigned flags = none) : glob(stdx::string(pattern), flags) {}
+        explicit glob(const wchar_t* pattern, unsigned flags = none) : glob(stdx::string(pattern), flags) {}
+        explicit glob(const std::string& pattern, unsigned flags = none) : glob(stdx::string(pattern), flags) {}
+        explicit glob(const std::wstring& pattern, unsigned flags = none) : glob(stdx::string(pattern), flags) {}
+
+        // Whole-text match. UTF-8 and wide text is decoded as it is read, so
+        // nothing is allocated for patterns of up to 512 positions.
+        inline bool matches(string_view text) const {
+            return run([&](auto&& step) {
+                text.visit([&](const auto* p) {
+                    for (size_t i = 0; i < text.size() && step((char32_t)p[i]); ++i) {}
+                });
+            });
+        }
+
+        inline bool matches(const stdx::string& text) const { return matches(text.view()); }
+        inline bool matches(const char* text) const { return matches_utf8(text, strlen(text)); }
+        inline bool matches(const std::string& text) const { return matches_utf8(text.data(), text.size()); }
+        inline bool matches(const wchar_t* text) const { return matches_wide(text, wcslen(text)); }
+        inline bool matches(const std::wstring& text) const { return matches_wide(text.data(), text.size()); }
+
+        template<typename T>
+        inline bool operator()(const T& text) const { return matches(text); }
+
+    private:
+        enum class kind : unsigned char { literal, any, star, set };
+
+        struct token {
+            kind type;
+            bool negate;
+            char32_t c;     // literal, folded under ignore_case
+            uint32_t first; // set: index into m_ranges
+            uint32_t count;
+        };
+
+        std::vector<token> m_tokens;
+        std::vector<std::pair<char32_t, char32_t>> m_ranges;
+        std::vector<uint64_t> m_table; // 256 masks of m_words each, for Latin-1 code points
+        std::vector<uint64_t> m_wild;  // positions any code point advances: '?' and '*'
+        std::vector<uint64_t> m_star;  // positions holding a '*'
+        std::vector<uint32_t> m_wide;  // positions that must be tested for code points above U+00FF
+        size_t m_words = 0;
+        unsigned m_flags = none;
+        bool m_tail_star = false;
+
+        inline bool icase() const { return (m_flags & ignore_case) != 0; }
+
+        inline bool in_set(const token& t, char32_t c) const {
+            for (uint32_t i = t.first; i < t.first + t.count; ++i) {
+                if (c >= m_ranges[i].first && c <= m_ranges[i].second) return true;
+            }
+            return false;
+        }
+
+        inline bool accepts(const token& t, char32_t c) const {
+            switch (t.type) {
+            case kind::literal: return (icase() ? unicode::fold(c) : c) == t.c;
+            case kind::set: {
+                bool in = in_set(t, c);
+                if (!in && icase()) in = in_set(t, unicode::fold(c)) || in_set(t, unicode::to_upper(c)) || in_set(t, unicode::to_lower(c));
+                return in != t.negate;
+            }
+            default: return true;
+            }
+        }
+
+        // Parses "[...]" at i; returns the index past the ']' or 0 if the
+        // set is never closed.
+        inline size_t parse_set(const std::u32string& p, size_t i) {
+            size_t j = i + 1;
+            bool negate = j < p.size() && (p[j] == U'!' || p[j] == U'^');
+            if (negate) ++j;
+            uint32_t first = (uint32_t)m_ranges.size();
+            for (bool leading = true; j < p.size(); leading = false) {
+                char32_t c = p[j];
+                if (c == U']' && !leading) {
+                    m_tokens.push_back({ kind::set, negate, 0, first, (uint32_t)m_ranges.size() - first });
+                    return j + 1;
+                }
+                if (j + 2 < p.size() && p[j + 1] == U'-' && p[j + 2] != U']') {
+                    m_ranges.emplace_back(c, p[j + 2]);
+                    j += 3;
+                }
+                else {
+                    m_ranges.emplace_back(c, c);
+                    ++j;
+                }
+            }
+            m_ranges.resize(first);
+            return 0;
+        }
+
+        inline void compile(string_view pattern, unsigned flags) {
+            m_flags = flags;
+            std::u32string p(pattern.size(), U'\0');
+            pattern.visit([&](const auto* s) { std::copy(s, s + pattern.size(), p.begin()); });
+
+            for (size_t i = 0; i < p.size();) {
+                char32_t c = p[i];
+                if (c == U'*') {
+                    // runs of '*' are one '*'
+                    if (m_tokens.empty() || m_tokens.back().type != kind::star) m_tokens.push_back({ kind::star, false, 0, 0, 0 });
+                    ++i;
+                    continue;
+                }
+                if (c == U'?') {
+                    m_tokens.push_back({ kind::any, false, 0, 0, 0 });
+                    ++i;
+                    continue;
+                }
+                if (c == U'[') {
+                    if (size_t end = parse_set(p, i)) { i = end; continue; }
+                }
+                m_tokens.push_back({ kind::literal, false, icase() ? unicode::fold(c) : c, 0, 0 });
+                ++i;
+            }
+
+            size_t m = m_tokens.size();
+            m_words = std::max<size_t>(1, (m + 63) / 64);
+            m_table.assign(256 * m_words, 0);
+            m_wild.assign(m_words, 0);
+            m_star.assign(m_words, 0);
+            m_tail_star = m > 0 && m_tokens.back().type == kind::star;
+
+            for (size_t j = 0; j < m; ++j) {
+                const token& t = m_tokens[j];
+                uint64_t bit = (uint64_t)1 << (j % 64);
+                if (t.type == kind::any || t.type == kind::star) m_wild[j / 64] |= bit;
+                if (t.type == kind::star) m_star[j / 64] |= bit;
+                if (t.type == kind::set || (t.type == kind::literal && t.c > 0xFF)) m_wide.push_back((uint32_t)j);
+                for (char32_t c = 0; c < 256; ++c) {
+                    if (accepts(t, c)) m_table[c * m_words + j / 64] |= bit;
+                }
+            }
+        }
+
+        // Positions code point c may advance. Latin-1 is a table lookup;
+        // anything wider starts from the wildcards (or, under ignore_case,
+        // from the Latin-1 entry of its folding: K-sign vs 'k') and decides
+        // the sets and non-Latin-1 literals again. A set must be cleared as
+        // well as set there: [!K] holds 'k' but not the K-sign.
+        inline const uint64_t* mask(char32_t c, uint64_t* scratch) const {
+            if (c < 256) return &m_table[c * m_words];
+            char32_t f = icase() ? unicode::fold(c) : c;
+            const uint64_t* base = f < 256 ? &m_table[f * m_words] : m_wild.data();
+            std::copy(base, base + m_words, scratch);
+            for (uint32_t j : m_wide) {
+                uint64_t bit = (uint64_t)1 << (j % 64);
+                if (accepts(m_tokens[j], c)) scratch[j / 64] |= bit;
+                else scratch[j / 64] &= ~bit;
+            }
+            return scratch;
+        }
+
+        inline bool last_set(const uint64_t* state) const {
+            size_t j = m_tokens.size() - 1;
+            return (state[j / 64] >> (j % 64)) & 1;
+        }
+
+        // source(step) calls step(cp) for each code point of the text until
+        // step returns false.
+        template<typename Source>
+        inline bool run(Source&& source) const {
+            if (m_tokens.empty()) {
+                bool empty = true;
+                source([&](char32_t) { empty = false; return false; });
+                return empty;
+            }
+
+            if (m_words == 1) {
+                // up to 64 positions: the whole state in one register
+                const uint64_t star = m_star[0], last = (uint64_t)1 << (m_tokens.size() - 1);
+                uint64_t state = m_tokens[0].type == kind::star ? 1 : 0, start = 1, scratch;
+                if (m_tail_star && (state & last)) return true;
+                source([&](char32_t c) {
+                    uint64_t b = c < 256 ? m_table[c] : *mask(c, &scratch);
+                    state = (((state << 1) | start) & b) | (state & star);
+                    state |= (state << 1) & star;
+                    start = 0;
+                    return state != 0 && !(m_tail_star && (state & last));
+                });
+                return (state & last) != 0;
+            }
+
+            uint64_t local[16];
+            std::unique_ptr<uint64_t[]> heap(m_words > 8 ? new uint64_t[m_words * 2] : nullptr);
+            uint64_t* state = heap ? heap.get() : local;
+            uint64_t* scratch = state + m_words;
+            std::fill(state, state + m_words, 0);
+            if (m_tokens[0].type == kind::star) state[0] = 1;
+            if (m_tail_star && last_set(state)) return true;
+
+            bool started = false, dead = false;
+            source([&](char32_t c) {
+                const uint64_t* b = mask(c, scratch);
+                // the start state feeds position 0 on the first code point only
+                uint64_t carry = started ? 0 : 1, any = 0;
+                started = true;
+                for (size_t w = 0; w < m_words; ++w) {
+                    uint64_t v = state[w];
+                    state[w] = (((v << 1) | carry) & b[w]) | (v & m_star[w]);
+                    carry = v >> 63;
+                }
+                // a '*' reached by its predecessor also matches the empty run;
+                // one pass is enough as no two '*' are adjacent
+                carry = 0;
+                for (size_t w = 0; w < m_words; ++w) {
+                    uint64_t v = state[w];
+                    state[w] |= ((v << 1) | carry) & m_star[w];
+                    carry = v >> 63;
+                    any |= state[w];
+                }
+                if (!any) {
+                    dead = true;
+                    return false;
+                }
+                return !(m_tail_star && last_set(state));
+            });
+            return !dead && last_set(state);
+        }
+
+        inline bool matches_utf8(const char* text, size_t n) const {
+            return run([&](auto&& step) {
+                const unsigned char* p = (const unsigned char*)text;
+                const unsigned char* end = p + n;
+                while (p < end) {
+                    char32_t cp = *p;
+                    if (cp < 0x80) ++p;
+                    else p += utf::detail::decode_sequence(p, end, cp);
+                    if (!step(cp)) break;
+                }
+            });
+        }
+
+        inline bool matches_wide(const wchar_t* text, size_t n) const {
+            return run([&](auto&& step) {
+                for (size_t i = 0; i < n;) {
+                    char32_t cp = (char32_t)text[i++];
+#ifdef _WIN32
+                    cp &= 0xFFFF;
+                    if (cp >= 0xD800 && cp <= 0xDBFF && i < n) {
+                        char32_t c2 = (char16_t)text[i];
+                        if (c2 >= 0xDC00 && c2 <= 0xDFFF) {
+                            cp = 0x10000 + (((cp - 0xD800) << 10) | (c2 - 0xDC00));
+                            ++i;
+                        }
+                    }
+#endif
+                    if (!step(cp)) break;
+                }
+            });
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "stdxutf.h"
+
+namespace stdx {
+    namespace hashing {
+        namespace detail {
+            static constexpr uint64_t prime32 = 0x9E3779B1u;
+            static constexpr uint64_t prime64_1 = 0x9E3779B185EBCA87ull;
+            static constexpr uint64_t prime64_2 = 0xC2B2AE3D27D4EB4Full;
+            static constexpr uint64_t prime64_3 = 0x165667B19E3779F9ull;
+
+            // Input is consumed in 64-byte stripes feeding eight 64-bit lanes;
+            // every stripes_per_block stripes the lanes are scrambled so long
+            // inputs cannot cancel out.
+            static constexpr size_t stripe_bytes = 64;
+            static constexpr size_t stripes_per_block = 16;
+            static constexpr size_t key_words = stripes_per_block + 8;
+
+            struct secret {
+                uint64_t words[key_words];
+            };
+
+            // splitmix64 over a fixed seed: stripe s is keyed by words [s, s+8),
+            // the block scramble by the last eight.
+            constexpr secret make_secret() {
+                secret s{};
+                uint64_t x = 0x5444584853545244ull;
+                for (size_t i = 0; i < key_words; ++i) {
+                    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+                    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                    s.words[i] = z ^ (z >> 31);
+                }
+                return s;
+            }
+
+            inline constexpr secret key = make_secret();
+
+            inline uint64_t read64(const unsigned char* p) {
+                uint64_t v;
+                memcpy(&v, p, sizeof(v));
+                return v;
+            }
+
+            inline uint32_t read32(const unsigned char* p) {
+                uint32_t v;
+                memcpy(&v, p, sizeof(v));
+                return v;
+            }
+
+            // 64x64 -> 128 bit product, high and low halves xor-ed together.
+            inline uint64_t mul_fold(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+                __extension__ typedef unsigned __int128 u128; // keeps -Wpedantic quiet
+                u128 r = (u128)a * b;
+                return (uint64_t)r ^ (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+                uint64_t hi;
+                uint64_t lo = _umul128(a, b, &hi);
+                return lo ^ hi;
+#else
+                uint64_t aLo = (uint32_t)a, aHi = a >> 32, bLo = (uint32_t)b, bHi = b >> 32;
+                uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+                uint64_t mid = (ll >> 32) + (uint32_t)lh + hl;
+                uint64_t lo = (mid << 32) | (uint32_t)ll;
+                uint64_t hi = hh + (lh >> 32) + (mid >> 32);
+                return lo ^ hi;
+#endif
+            }
+
+            inline uint64_t avalanche(uint64_t h) {
+                h ^= h >> 37;
+                h *= prime64_3;
+                return h ^ (h >> 32);
+            }
+
+            inline uint64_t mix16(const unsigned char* p, uint64_t k0, uint64_t k1) {
+                return mul_fold(read64(p) ^ k0, read64(p + 8) ^ k1);
+            }
+
+            // Inputs of at most one stripe never touch the lanes.
+            inline uint64_t hash_short(const unsigned char* p, size_t n) {
+                const uint64_t* k = key.words;
+                if (n > 16) {
+                    uint64_t acc = n * prime64_1;
+                    if (n > 32) {
+                        acc += mix16(p + 16, k[4], k[5]);
+                        acc += mix16(p + n - 32, k[6], k[7]);
+                    }
+                    acc += mix16(p, k[0], k[1]);
+                    acc += mix16(p + n - 16, k[2], k[3]);
+                    return avalanche(acc);
+                }
+                if (n > 8) {
+                    uint64_t lo = read64(p) ^ k[0], hi = read64(p + n - 8) ^ k[1];
+                    return avalanche(n + lo + (hi << 1 | hi >> 63) + mul_fold(lo, hi));
+                }
+                if (n >= 4) {
+                    uint64_t v = (read32(p) | (uint64_t)read32(p + n - 4) << 32) ^ k[2];
+                    v ^= (v << 49 | v >> 15) ^ (v << 24 | v >> 40);
+                    v *= prime64_2;
+                    v ^= (v >> 35) + n;
+                    v *= prime64_2;
+                    return v ^ (v >> 28);
+                }
+                if (n > 0) {
+                    uint64_t v = (uint64_t)p[0] << 16 | (uint64_t)p[n >> 1] << 24 | p[n - 1] | (uint64_t)n << 8;
+                    return avalanche(v ^ k[3]);
+                }
+                return avalanche(k[4] ^ k[5]);
+            }
+
+            // Feeds count stripes into acc; stripe is the position of the first
+            // one within its block and is advanced past the last.
+            inline void accumulate(uint64_t* acc, const unsigned char* p, size_t count, size_t& stripe) {
+#if defined(STDX_UTF_AVX2)
+                __m256i a0 = _mm256_loadu_si256((const __m256i*)acc);
+                __m256i a1 = _mm256_loadu_si256((const __m256i*)(acc + 4));
+                for (; count > 0; --count, p += stripe_bytes) {
+                    const uint64_t* k = key.words + stripe;
+                    __m256i d0 = _mm256_loadu_si256((const __m256i*)p);
+                    __m256i d1 = _mm256_loadu_si256((const __m256i*)(p + 32));
+                    __m256i x0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i*)k));
+                    __m256i x1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i*)(k + 4)));
+                    a0 = _mm256_add_epi64(a0, _mm256_add_epi64(_mm256_mul_epu32(x0, _mm256_srli_epi64(x0, 32)),
+                        _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+                    a1 = _mm256_add_epi64(a1, _mm256_add_epi64(_mm256_mul_epu32(x1, _mm256_srli_epi64(x1, 32)),
+                        _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+                    if (++stripe == stripes_per_block) {
+                        const uint64_t* s = key.words + stripes_per_block;
+                        __m256i p32 = _mm256_set1_epi64x((long long)prime32);
+                        a0 = _mm256_xor_si256(_mm256_xor_si256(a0, _mm256_srli_epi64(a0, 47)), _mm256_loadu_si256((const __m256i*)s));
+                        a1 = _mm256_xor_si256(_mm256_xor_si256(a1, _mm256_srli_epi64(a1, 47)), _mm256_loadu_si256((const __m256i*)(s + 4)));
+                        a0 = _mm256_add_epi64(_mm256_mul_epu32(a0, p32), _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a0, 32), p32), 32));
+                        a1 = _mm256_add_epi64(_mm256_mul_epu32(a1, p32), _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a1, 32), p32), 32));
+                        stripe = 0;
+                    }
+                }
+                _mm256_storeu_si256((__m256i*)acc, a0);
+                _mm256_storeu_si256((__m256i*)(acc + 4), a1);
+#elif STDX_UTF_SSE2
+                __m128i a[4];
+                for (int i = 0; i < 4; ++i) a[i] = _mm_loadu_si128((const __m128i*)(acc + 2 * i));
+                for (; count > 0; --count, p += stripe_bytes) {
+                    const uint64_t* k = key.words + stripe;
+                    for (int i = 0; i < 4; ++i) {
+                        __m128i d = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+                        __m128i x = _mm_xor_si128(d, _mm_loadu_si128((const __m128i*)(k + 2 * i)));
+                        a[i] = _mm_add_epi64(a[i], _mm_add_epi64(_mm_mul_epu32(x, _mm_srli_epi64(x, 32)),
+                            _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2))));
+                    }
+                    if (++stripe == stripes_per_block) {
+                        const uint64_t* s = key.words + stripes_per_block;
+                        __m128i p32 = _mm_set1_epi32((int)prime32);
+                        for (int i = 0; i < 4; ++i) {
+                            __m128i v = _mm_xor_si128(_mm_xor_si128(a[i], _mm_srli_epi64(a[i], 47)), _mm_loadu_si128((const __m128i*)(s + 2 * i)));
+                            a[i] = _mm_add_epi64(_mm_mul_epu32(v, p32), _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(v, 32), p32), 32));
+                        }
+                        stripe = 0;
+                    }
+                }
+                for (int i = 0; i < 4; ++i) _mm_storeu_si128((__m128i*)(acc + 2 * i), a[i]);
+#else
+                for (; count > 0; --count, p += stripe_bytes) {
+                    const uint64_t* k = key.words + stripe;
+                    for (size_t i = 0; i < 8; ++i) {
+                        uint64_t d = read64(p + 8 * i), x = d ^ k[i];
+                        acc[i ^ 1] += d;
+                        acc[i] += (x & 0xFFFFFFFF) * (x >> 32);
+                    }
+                    if (++stripe == stripes_per_block) {
+                        const uint64_t* s = key.words + stripes_per_block;
+                        for (size_t i = 0; i < 8; ++i) acc[i] = (acc[i] ^ (acc[i] >> 47) ^ s[i]) * prime32;
+                        stripe = 0;
+                    }
+                }
+#endif
+            }
+        }
+
+        //============================
+        // hasher (streaming 64-bit non-cryptographic hash)
+        //============================
+        // Any split of the same bytes across update() calls gives the same
+        // digest as hashing them in one go.
+        class hasher {
+        public:
+            inline void update(const void* data, size_t n) {
+                const unsigned char* p = (const unsigned char*)data;
+                if (n == 0) return;
+                m_total += n;
+                if (m_buffered > 0) {
+                    size_t take = std::min(n, detail::stripe_bytes - m_buffered);
+                    memcpy(m_buffer + m_buffered, p, take);
+                    m_buffered += take;
+                    p += take;
+                    n -= take;
+                    if (n == 0) return;
+                    // more follows, so the full buffer is not the last stripe
+                    detail::accumulate(m_acc, m_buffer, 1, m_stripe);
+                    m_buffered = 0;
+                }
+                if (n > detail::stripe_bytes) {
+                    size_t count = (n - 1) / detail::stripe_bytes;
+                    detail::accumulate(m_acc, p, count, m_stripe);
+                    p += count * detail::stripe_bytes;
+                    n -= count * detail::stripe_bytes;
+                }
+                memcpy(m_buffer, p, n);
+                m_buffered = n;
+            }
+
+            inline uint64_t digest() const {
+                if (m_total <= detail::stripe_bytes) return detail::hash_short(m_buffer, m_buffered);
+                uint64_t acc[8];
+                memcpy(acc, m_acc, sizeof(acc));
+                unsigned char last[detail::stripe_bytes] = {};
+                memcpy(last, m_buffer, m_buffered);
+                size_t stripe = m_stripe;
+                detail::accumulate(acc, last, 1, stripe);
+                uint64_t result = m_total * detail::prime64_1;
+                for (size_t i = 0; i < 4; ++i) {
+                    result += detail::mul_fold(acc[2 * i] ^ detail::key.words[3 + 2 * i], acc[2 * i + 1] ^ detail::key.words[4 + 2 * i]);
+                }
+                return detail::avalanche(result);
+            }
+
+        private:
+            uint64_t m_acc[8] = {
+                detail::prime32, detail::prime64_1, detail::prime64_2, detail::prime64_3,
+                detail::prime64_1 ^ detail::prime32, detail::prime64_2 ^ detail::prime32,
+                detail::prime64_3 ^ detail::prime32, detail::prime64_1 + detail::prime64_2 };
+            size_t m_stripe = 0;
+            size_t m_total = 0;
+            size_t m_buffered = 0;
+            unsigned char m_buffer[detail::stripe_bytes];
+        };
+
+        inline uint64_t hash_bytes(const void* data, size_t n) {
+            if (n <= detail::stripe_bytes) return detail::hash_short((const unsigned char*)data, n);
+            hasher h;
+            h.update(data, n);
+            return h.digest();
+        }
+    }
+}
\ No newline at end of file
@@ -18,8 +18,17 @@
 #define CPP_AT_LEAST(ver) (CPP_STD >= ver)
 
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <cstdio>
+#include <cmath>
 #include <sstream>
 #include <ostream>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
 #ifdef _WIN32
 #   include <io.h>            // _write, STDOUT, STDERR (Windows)
 #else
@@ -27,6 +36,14 @@
 #endif
 #include <cstddef>
 
+// Floating-point std::to_chars where the library has it, else snprintf;
+// stdxstring.h decides it the same way for append_number and parse.
+// Defining STDX_NO_FLOAT_TO_CHARS takes the snprintf path anyway, so it
+// can be tested on a library that has both.
+#if !defined(STDX_FLOAT_TO_CHARS) && defined(__cpp_lib_to_chars) && !defined(STDX_NO_FLOAT_TO_CHARS)
+#   define STDX_FLOAT_TO_CHARS 1
+#endif
+
 namespace stdx {
 #ifndef STDX_FILE_DESCRIPTOR
 #define STDX_FILE_DESCRIPTOR
@@ -37,77 +54,484 @@ namespace stdx {
     };
 #endif
 
-    template<typename T>
-    inline size_t replace_first_brace(std::string& s, const T& value) {
-        size_t start = s.find('{');
-        if (start == std::string::npos) return 0;
-        size_t end = s.find('}', start);
-        if (end == std::string::npos) return 0;
-
-        std::ostringstream oss;
-        oss << value;
-        std::string rep = oss.str();
-        s.replace(start, end - start + 1, rep);
-        return rep.size();
-    }
-
-    inline size_t count_placeholders(const std::string& s) {
+    // A placeholder is a '{' and everything up to the next '}'.
+    constexpr size_t count_placeholders(std::string_view s) {
         size_t count = 0, pos = 0;
-        while ((pos = s.find('{', pos)) != std::string::npos) {
+        while ((pos = s.find('{', pos)) != std::string_view::npos) {
             size_t end = s.find('}', pos);
-            if (end != std::string::npos) { count++; pos = end + 1; }
+            if (end != std::string_view::npos) { count++; pos = end + 1; }
             else break;
         }
         return count;
     }
 
+    namespace detail {
+        // Offsets into the format string: the text before a placeholder,
+        // then what is between its braces.
+        // [[fill]align][sign][#][0][width][.precision][type], after a ':'
+        // in the placeholder; anything before the ':' is ignored, as is a
+        // placeholder with no ':'. fill is one UTF-8 code point.
+        struct format_spec {
+            char fill[4] = { ' ' };
+            unsigned char fill_size = 1;
+            char align = 0;         // '<', '>', '^'; 0: the type's default
+            char sign = 0;          // '+', ' ', '-'; 0: '-'
+            bool alternate = false; // 0x, 0b, 0 prefixes for integers
+            bool zero = false;      // pad numbers with '0' after the sign
+            int width = 0;
+            int precision = -1;
+            char type = 0;          // b B c d o x X / a A e E f F g G / s
+        };
+
+        struct format_segment {
+            size_t literal = 0, literal_size = 0;
+            format_spec spec;
+        };
+
+        constexpr bool parse_spec_number(std::string_view s, size_t& i, int& value) {
+            if (i >= s.size() || s[i] < '0' || s[i] > '9') return false;
+            value = 0;
+            for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+                if (value > 100000) return false;
+                value = value * 10 + (s[i] - '0');
+            }
+            return true;
+        }
+
+        // false if the spec is malformed; spec is then left partly filled.
+        constexpr bool parse_spec(std::string_view s, format_spec& spec) {
+            size_t colon = s.find(':');
+            if (colon == std::string_view::npos) return true;
+            s.remove_prefix(colon + 1);
+
+            auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+            size_t i = 0;
+            unsigned char lead = s.empty() ? 0 : (unsigned char)s[0];
+            size_t fill = lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+            if (s.size() > fill && is_align(s[fill])) {
+                for (size_t k = 0; k < fill; ++k) spec.fill[k] = s[k];
+                spec.fill_size = (unsigned char)fill;
+                spec.align = s[fill];
+                i = fill + 1;
+            }
+            else if (!s.empty() && is_align(s[0])) {
+                spec.align = s[0];
+                i = 1;
+            }
+            if (i < s.size() && (s[i] == '+' || s[i] == '-' || s[i] == ' ')) spec.sign = s[i++];
+            if (i < s.size() && s[i] == '#') { spec.alternate = true; ++i; }
+            if (i < s.size() && s[i] == '0') { spec.zero = true; ++i; }
+            if (i < s.size() && s[i] >= '1' && s[i] <= '9' && !parse_spec_number(s, i, spec.width)) return false;
+            if (i < s.size() && s[i] == '.' && !parse_spec_number(s, ++i, spec.precision)) return false;
+            if (i < s.size() && std::string_view("bBcdoxXaAeEfFgGs").find(s[i]) != std::string_view::npos) spec.type = s[i++];
+            return i == s.size();
+        }
+
+        // Not constexpr: reaching one while a format string is checked at
+        // compile time is the error.
+        inline void format_placeholders_do_not_match_arguments() {}
+        inline void format_spec_is_malformed() {}
+
+        // Output assembled in place: on the stack up to 512 bytes, then on
+        // the heap.
+        class format_buffer {
+        public:
+            format_buffer() = default;
+            format_buffer(const format_buffer&) = delete;
+            format_buffer& operator=(const format_buffer&) = delete;
+
+            inline void append(const char* s, size_t n) {
+                if (n > m_capacity - m_size) grow(n);
+                if (n) memcpy(m_data + m_size, s, n);
+                m_size += n;
+            }
+
+            inline void append(std::string_view s) { append(s.data(), s.size()); }
+
+            inline void append(size_t count, char c) {
+                if (count > m_capacity - m_size) grow(count);
+                memset(m_data + m_size, c, count);
+                m_size += count;
+            }
+
+            inline void push_back(char c) {
+                if (m_size == m_capacity) grow(1);
+                m_data[m_size++] = c;
+            }
+
+            inline const char* data() const { return m_data; }
+            inline size_t size() const { return m_size; }
+
+        private:
+            char m_local[512];
+            std::unique_ptr<char[]> m_heap;
+            char* m_data = m_local;
+            size_t m_size = 0;
+            size_t m_capacity = sizeof(m_local);
+
+            inline void grow(size_t n) {
+                size_t capacity = std::max(m_capacity * 2, m_size + n);
+                std::unique_ptr<char[]> heap(new char[capacity]);
+                memcpy(heap.get(), m_data, m_size);
+                m_heap = std::move(heap);
+                m_data = m_heap.get();
+                m_capacity = capacity;
+            }
+        };
+    }
+
+    // Wraps a message only known at run time. It is parsed when used, and
+    // a placeholder/argument mismatch is tolerated as Print always has:
+    // surplus arguments are dropped and surplus placeholders printed.
+    struct runtime_format_string {
+        std::string_view text;
+    };
+
+    inline runtime_format_string runtime_format(std::string_view text) { return { text }; }
+
+    //============================
+    // Format strings
+    //============================
+    // A message split, once, into the literal text around each placeholder
+    // and the parsed spec of each (see detail::format_spec). Under C++20
+    // that happens at compile time, and a message whose placeholders
+    // (count_placeholders) do not match the arguments, or with a malformed
+    // spec, fails to compile; earlier standards split it when the call is
+    // made and format a value with a malformed spec as if it had none. A
+    // message with no arguments is printed as it is, and one held in a
+    // string object is split at run time, as runtime_format would.
+    //
+    // This breaks one call that used to compile: under C++20, a message
+    // with arguments must be a constant expression, so Print(fmt, 1) with a
+    // run-time const char* (or std::string_view) fmt is rejected ("not
+    // usable in a constant expression"). Wrap it: Print(runtime_format(fmt), 1).
     template<typename... Args>
-    inline void Print(const std::string& message, Args&&... args) {
-        std::string formatted = message;
-#if CPP_AT_LEAST(CPP17)
-        (replace_first_brace(formatted, std::forward<Args>(args)), ...);
+    class basic_format_string {
+    public:
+        static constexpr size_t arity = sizeof...(Args);
+
+#if CPP_AT_LEAST(CPP20)
+        template<typename S> requires (arity > 0 && std::is_convertible_v<const S&, std::string_view>)
+        consteval basic_format_string(const S& s) : m_text(s) {
+            if (count_placeholders(m_text) != arity) detail::format_placeholders_do_not_match_arguments();
+            if (!parse()) detail::format_spec_is_malformed();
+        }
+
+        template<typename S> requires (arity == 0 && std::is_convertible_v<const S&, std::string_view>)
+        constexpr basic_format_string(const S& s) : m_text(s) {}
 #else
-        using expander = int[];
-        expander{ 0, (replace_first_brace(formatted, std::forward<Args>(args)), 0)... };
+        template<typename S, typename = std::enable_if_t<std::is_convertible_v<const S&, std::string_view>>>
+        basic_format_string(const S& s) : m_text(s) { parse(); }
 #endif
-        _write(STDOUT, formatted.c_str(), (unsigned int)formatted.size());
-    }
 
+        basic_format_string(runtime_format_string s) : m_text(s.text) { parse(); }
+
+        // Messages held in a std::string are taken as runtime_format ones.
+        basic_format_string(const std::string& s) : m_text(s) { parse(); }
+
+        // So are string types that only convert to std::string (stdx::string,
+        // stdx::string_view). The UTF-8 copy goes in utf8, a temporary that
+        // lives until the Print call it was made for returns.
+        template<typename S, typename = std::enable_if_t<std::is_class_v<S> &&
+            !std::is_convertible_v<const S&, std::string_view> && std::is_constructible_v<std::string, const S&>>>
+        basic_format_string(const S& s, std::string&& utf8 = std::string()) : m_text(utf8 = std::string(s)) { parse(); }
+
+        inline constexpr std::string_view get() const { return m_text; }
+
+        // Placeholders found (at most arity), each with the text before it,
+        // and where the text after the last one starts.
+        inline constexpr size_t placeholders() const { return m_count; }
+        inline constexpr const detail::format_segment& segment(size_t i) const { return m_segments[i]; }
+        inline constexpr size_t tail() const { return m_tail; }
+
+    private:
+        std::string_view m_text;
+        detail::format_segment m_segments[arity + 1] = {};
+        size_t m_count = 0;
+        size_t m_tail = 0;
+
+        // false if a spec is malformed; that placeholder gets the default.
+        constexpr bool parse() {
+            size_t pos = 0;
+            bool valid = true;
+            while (m_count < arity) {
+                size_t open = m_text.find('{', pos);
+                if (open == std::string_view::npos) break;
+                size_t close = m_text.find('}', open);
+                if (close == std::string_view::npos) break;
+                detail::format_segment& s = m_segments[m_count++];
+                s.literal = pos;
+                s.literal_size = open - pos;
+                if (!detail::parse_spec(m_text.substr(open + 1, close - open - 1), s.spec)) {
+                    s.spec = detail::format_spec();
+                    valid = false;
+                }
+                pos = close + 1;
+            }
+            m_tail = pos;
+            return valid;
+        }
+    };
+
+    // The message parameter of Print and friends; not deduced from it.
     template<typename... Args>
-    inline void PrintLine(const std::string& message, Args&&... args) {
-        std::string formatted = message;
-#if CPP_AT_LEAST(CPP17)
-        (replace_first_brace(formatted, std::forward<Args>(args)), ...);
+    using format_string = basic_format_string<std::decay_t<Args>...>;
+
+    namespace detail {
+        //============================
+        // Formatting values
+        //============================
+        inline void write_fill(format_buffer& out, const format_spec& spec, size_t count) {
+            if (spec.fill_size == 1) out.append(count, spec.fill[0]);
+            else while (count--) out.append(spec.fill, spec.fill_size);
+        }
+
+        // prefix (sign, 0x) then body, padded to spec.width; width is how
+        // many columns the two take up.
+        inline void write_padded(format_buffer& out, const format_spec& spec, std::string_view prefix, std::string_view body, size_t width, char align, bool numeric) {
+            size_t pad = (size_t)spec.width > width ? (size_t)spec.width - width : 0;
+            if (numeric && spec.zero && !spec.align) {
+                out.append(prefix);
+                out.append(pad, '0');
+                out.append(body);
+                return;
+            }
+            if (spec.align) align = spec.align;
+            size_t before = align == '>' ? pad : align == '^' ? pad / 2 : 0;
+            write_fill(out, spec, before);
+            out.append(prefix);
+            out.append(body);
+            write_fill(out, spec, pad - before);
+        }
+
+        inline void to_upper(char* first, char* last) {
+            for (; first != last; ++first) {
+                if (*first >= 'a' && *first <= 'z') *first -= 'a' - 'A';
+            }
+        }
+
+        // Moves a leading '-' of body, or the sign spec asks for, into sign.
+        inline size_t take_sign(std::string_view& body, const format_spec& spec, char* sign) {
+            if (!body.empty() && body[0] == '-') {
+                body.remove_prefix(1);
+                *sign = '-';
+                return 1;
+            }
+            if (spec.sign == '+' || spec.sign == ' ') {
+                *sign = spec.sign;
+                return 1;
+            }
+            return 0;
+        }
+
+        inline void format_text(format_buffer& out, std::string_view s, const format_spec& spec) {
+            if (spec.width == 0 && spec.precision < 0) {
+                out.append(s);
+                return;
+            }
+            // width and precision count code points, not bytes
+            size_t points = 0, end = s.size();
+            for (size_t i = 0; i < s.size(); ++i) {
+                if (((unsigned char)s[i] & 0xC0) == 0x80) continue;
+                if (spec.precision >= 0 && points == (size_t)spec.precision) {
+                    end = i;
+                    break;
+                }
+                ++points;
+            }
+            write_padded(out, spec, std::string_view(), s.substr(0, end), points, '<', false);
+        }
+
+        template<typename T>
+        inline void format_integer(format_buffer& out, T value, const format_spec& spec) {
+            if (spec.type == 'c') {
+                char c = (char)value;
+                write_padded(out, spec, std::string_view(), std::string_view(&c, 1), 1, '<', false);
+                return;
+            }
+            int base = 10;
+            const char* radix = "";
+            switch (spec.type) {
+            case 'x': base = 16; radix = "0x"; break;
+            case 'X': base = 16; radix = "0X"; break;
+            case 'b': base = 2; radix = "0b"; break;
+            case 'B': base = 2; radix = "0B"; break;
+            case 'o': base = 8; radix = "0"; break;
+            }
+            using wide = std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>;
+            char digits[sizeof(wide) * 8 + 1];
+            char* end = std::to_chars(digits, digits + sizeof(digits), (wide)value, base).ptr;
+            if (spec.type == 'X') to_upper(digits, end);
+            std::string_view body(digits, end - digits);
+
+            char prefix[3];
+            size_t n = take_sign(body, spec, prefix);
+            if (spec.alternate && !(base == 8 && body == "0")) {
+                for (const char* r = radix; *r; ++r) prefix[n++] = *r;
+            }
+            write_padded(out, spec, std::string_view(prefix, n), body, n + body.size(), '>', true);
+        }
+
+        // nullptr if [first, last) is too small.
+        template<typename T>
+        inline char* float_chars(char* first, char* last, T value, const format_spec& spec) {
+            int precision = spec.precision;
+#if defined(STDX_FLOAT_TO_CHARS)
+            std::to_chars_result r;
+            switch (spec.type) {
+            case 'f': case 'F': r = std::to_chars(first, last, value, std::chars_format::fixed, precision < 0 ? 6 : precision); break;
+            case 'e': case 'E': r = std::to_chars(first, last, value, std::chars_format::scientific, precision < 0 ? 6 : precision); break;
+            case 'a': case 'A':
+                r = precision < 0 ? std::to_chars(first, last, value, std::chars_format::hex)
+                                  : std::to_chars(first, last, value, std::chars_format::hex, precision);
+                break;
+            default: r = std::to_chars(first, last, value, std::chars_format::general, precision < 0 ? 6 : precision); break;
+            }
+            return r.ec == std::errc() ? r.ptr : nullptr;
 #else
-        using expander = int[];
-        expander{ 0, (replace_first_brace(formatted, std::forward<Args>(args)), 0)... };
+            // no floating-point to_chars in this library: fall back to printf
+            char conversion = 'g';
+            switch (spec.type) {
+            case 'f': case 'F': conversion = 'f'; break;
+            case 'e': case 'E': conversion = 'e'; break;
+            case 'a': case 'A': conversion = 'a'; break;
+            }
+            if (precision < 0 && conversion != 'a') precision = 6;
+            char format[] = { '%', '.', '*', 'L', conversion, 0 };
+            int n;
+            if constexpr (std::is_same_v<T, long double>) n = snprintf(first, last - first, format, precision, value);
+            else {
+                format[3] = conversion;
+                format[4] = 0;
+                n = snprintf(first, last - first, format, precision, (double)value);
+            }
+            if (n < 0 || n >= last - first) return nullptr;
+            char* digits = first + (*first == '-');
+            if (conversion == 'a' && digits[0] == '0' && digits[1] == 'x') {
+                // to_chars leaves out the 0x
+                memmove(digits, digits + 2, first + n - digits - 2);
+                n -= 2;
+            }
+            return first + n;
 #endif
-        formatted += "\n";
-        _write(STDOUT, formatted.c_str(), (unsigned int)formatted.size());
+        }
+
+        template<typename T>
+        inline void format_float(format_buffer& out, T value, const format_spec& spec) {
+            char local[128];
+            std::unique_ptr<char[]> heap;
+            char* digits = local;
+            size_t capacity = sizeof(local);
+            char* end;
+            while (!(end = float_chars(digits, digits + capacity, value, spec))) {
+                capacity *= 4;
+                heap.reset(new char[capacity]);
+                digits = heap.get();
+            }
+            if (spec.type >= 'A' && spec.type <= 'Z') to_upper(digits, end);
+            std::string_view body(digits, end - digits);
+
+            char sign;
+            size_t n = take_sign(body, spec, &sign);
+            write_padded(out, spec, std::string_view(&sign, n), body, n + body.size(), '>', std::isfinite(value));
+        }
+
+        template<typename T>
+        constexpr bool is_narrow_char = std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>;
+
+        // Numbers through to_chars and text by copy, straight into out; only
+        // other types go through their operator<<. Unspecified, each prints
+        // as operator<< would (so bool is 1/0 and a double has 6 significant
+        // digits); bool with 's' prints true/false.
+        template<typename T>
+        inline void format_value(format_buffer& out, const T& value, const format_spec& spec) {
+            if constexpr (std::is_same_v<T, bool>) {
+                if (spec.type == 's') format_text(out, value ? "true" : "false", spec);
+                else format_integer(out, (unsigned)value, spec);
+            }
+            else if constexpr (is_narrow_char<T>) {
+                if (spec.type && spec.type != 'c') format_integer(out, value, spec);
+                else write_padded(out, spec, std::string_view(), std::string_view((const char*)&value, 1), 1, '<', false);
+            }
+            else if constexpr (std::is_integral_v<T>) {
+                format_integer(out, value, spec);
+            }
+            else if constexpr (std::is_floating_point_v<T>) {
+                format_float(out, value, spec);
+            }
+            else if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+                format_text(out, value ? std::string_view(value) : std::string_view(), spec);
+            }
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+                format_text(out, std::string_view(value), spec);
+            }
+            else {
+                std::ostringstream oss;
+                oss << value;
+                format_text(out, oss.str(), spec);
+            }
+        }
+
+        // One forward pass over the message: each literal, then its value.
+        template<typename... Fmt, typename... Args>
+        inline void format_to(format_buffer& out, const basic_format_string<Fmt...>& message, const Args&... args) {
+            std::string_view text = message.get();
+            size_t i = 0;
+            auto next = [&](const auto& value) {
+                if (i < message.placeholders()) {
+                    const format_segment& s = message.segment(i);
+                    out.append(text.data() + s.literal, s.literal_size);
+                    format_value(out, value, s.spec);
+                }
+                ++i;
+            };
+            (next(args), ...);
+            (void)next;
+            out.append(text.data() + message.tail(), text.size() - message.tail());
+        }
+
+        template<typename... Fmt, typename... Args>
+        inline void write_formatted(int fd, bool newline, const basic_format_string<Fmt...>& message, const Args&... args) {
+            format_buffer out;
+            format_to(out, message, args...);
+            if (newline) out.push_back('\n');
+            _write(fd, out.data(), (unsigned int)out.size());
+        }
+    }
+
+    // Formats value as Print would into the first placeholder of s.
+    template<typename T>
+    inline size_t replace_first_brace(std::string& s, const T& value) {
+        size_t start = s.find('{');
+        if (start == std::string::npos) return 0;
+        size_t end = s.find('}', start);
+        if (end == std::string::npos) return 0;
+
+        detail::format_spec spec;
+        if (!detail::parse_spec(std::string_view(s).substr(start + 1, end - start - 1), spec)) spec = detail::format_spec();
+        detail::format_buffer rep;
+        detail::format_value(rep, value, spec);
+        s.replace(start, end - start + 1, rep.data(), rep.size());
+        return rep.size();
     }
 
     template<typename... Args>
-    inline void PrintErr(const std::string& message, Args&&... args) {
-        std::string formatted = message;
-#if CPP_AT_LEAST(CPP17)
-        (replace_first_brace(formatted, std::forward<Args>(args)), ...);
-#else
-        using expander = int[];
-        expander{ 0, (replace_first_brace(formatted, std::forward<Args>(args)), 0)... };
-#endif
-        _write(STDERR, formatted.c_str(), (unsigned int)formatted.size());
+    inline void Print(format_string<Args...> message, Args&&... args) {
+        detail::write_formatted(STDOUT, false, message, args...);
     }
 
     template<typename... Args>
-    inline void PrintLineErr(const std::string& message, Args&&... args) {
-        std::string formatted = message;
-#if CPP_AT_LEAST(CPP17)
-        (replace_first_brace(formatted, std::forward<Args>(args)), ...);
-#else
-        using expander = int[];
-        expander{ 0, (replace_first_brace(formatted, std::forward<Args>(args)), 0)... };
-#endif
-        formatted += "\n";
-        _write(STDERR, formatted.c_str(), (unsigned int)formatted.size());
+    inline void PrintLine(format_string<Args...> message, Args&&... args) {
+        detail::write_formatted(STDOUT, true, message, args...);
+    }
+
+    template<typename... Args>
+    inline void PrintErr(format_string<Args...> message, Args&&... args) {
+        detail::write_formatted(STDERR, false, message, args...);
+    }
+
+    template<typename... Args>
+    inline void PrintLineErr(format_string<Args...> message, Args&&... args) {
+        detail::write_formatted(STDERR, true, message, args...);
     }
 }
\ No newline at end of file
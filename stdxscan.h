@@ -0,0 +1,516 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "stdxutf.h"
+
+//============================
+// Runtime dispatch
+//============================
+// x86 builds without -mavx2 (/arch:AVX2) still carry AVX2 kernels: they are
+// compiled for AVX2 one function at a time and picked at run time when the
+// CPU and OS support it. SSE2 is the baseline; without SSE2 the scalar
+// loops run.
+#if defined(STDX_UTF_AVX2)
+#   define STDX_SCAN_AVX2 1
+#   define STDX_SCAN_AVX2_FN
+#elif defined(STDX_UTF_SSE2) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#   define STDX_SCAN_AVX2 1
+#   define STDX_SCAN_DISPATCH 1
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       define STDX_SCAN_AVX2_FN
+#   else
+#       define STDX_SCAN_AVX2_FN __attribute__((target("avx2")))
+#   endif
+#   include <immintrin.h>
+#endif
+
+namespace stdx {
+    namespace scan {
+        static constexpr size_t npos = (size_t)-1;
+
+        // Up to eight code points; testing a unit against the set costs one
+        // compare per member, so it suits small sets such as whitespace.
+        struct small_set {
+            static constexpr size_t capacity = 8;
+            char32_t members[capacity];
+            size_t size;
+
+            inline bool contains(char32_t c) const {
+                for (size_t i = 0; i < size; ++i) {
+                    if (members[i] == c) return true;
+                }
+                return false;
+            }
+        };
+
+        // Trimmed by trim()/trimmed(), and everything isspace() accepts.
+        static constexpr small_set trim_spaces = { { U' ', U'\t', U'\n', U'\r' }, 4 };
+        static constexpr small_set white_spaces = { { U' ', U'\t', U'\n', U'\r', U'\f', U'\v' }, 6 };
+
+        namespace detail {
+            template<typename Unit>
+            inline constexpr char32_t unit_max() {
+                return sizeof(Unit) == 1 ? 0xFF : sizeof(Unit) == 2 ? 0xFFFF : 0xFFFFFFFF;
+            }
+
+            inline unsigned clz(uint32_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+                unsigned long i;
+                _BitScanReverse(&i, v);
+                return 31 - (unsigned)i;
+#else
+                return (unsigned)__builtin_clz(v);
+#endif
+            }
+
+            // Unit index of the first / last unit flagged in a byte-granular
+            // movemask (each unit sets sizeof(Unit) bits).
+            template<typename Unit>
+            inline size_t first_lane(uint32_t mask) { return utf::detail::ctz(mask) / sizeof(Unit); }
+
+            template<typename Unit>
+            inline size_t last_lane(uint32_t mask) { return (31 - clz(mask)) / sizeof(Unit); }
+
+#if defined(STDX_SCAN_AVX2)
+            // Read on every dispatch, so relaxed: a scan running while the
+            // flag flips may take either tier, both give the same results.
+            inline std::atomic<bool>& avx2_allowed() {
+                static std::atomic<bool> allowed{ true };
+                return allowed;
+            }
+
+            inline bool avx2() {
+#if !defined(STDX_SCAN_DISPATCH)
+                return avx2_allowed().load(std::memory_order_relaxed);
+#elif defined(_MSC_VER) && !defined(__clang__)
+                static const bool supported = [] {
+                    int r[4];
+                    __cpuid(r, 0);
+                    if (r[0] < 7) return false;
+                    __cpuid(r, 1);
+                    // AVX, and the OS saves the YMM registers
+                    if (!(r[2] & (1 << 27)) || !(r[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) return false;
+                    __cpuidex(r, 7, 0);
+                    return (r[1] & (1 << 5)) != 0;
+                }();
+                return supported && avx2_allowed().load(std::memory_order_relaxed);
+#else
+                static const bool supported = [] {
+                    __builtin_cpu_init();
+                    return __builtin_cpu_supports("avx2") != 0;
+                }();
+                return supported && avx2_allowed().load(std::memory_order_relaxed);
+#endif
+            }
+#endif
+
+            //============================
+            // SSE2 kernels
+            //============================
+            // Each one works through whole blocks from i (or back from end),
+            // returning true with i / end on a hit or false with i / end
+            // where the caller's scalar loop takes over.
+#if defined(STDX_UTF_SSE2)
+            template<typename Unit>
+            inline __m128i splat(char32_t c) {
+                if constexpr (sizeof(Unit) == 1) return _mm_set1_epi8((char)c);
+                else if constexpr (sizeof(Unit) == 2) return _mm_set1_epi16((short)c);
+                else return _mm_set1_epi32((int)c);
+            }
+
+            template<typename Unit>
+            inline __m128i equal(__m128i a, __m128i b) {
+                if constexpr (sizeof(Unit) == 1) return _mm_cmpeq_epi8(a, b);
+                else if constexpr (sizeof(Unit) == 2) return _mm_cmpeq_epi16(a, b);
+                else return _mm_cmpeq_epi32(a, b);
+            }
+
+            template<typename Unit>
+            inline bool find_sse2(const Unit* p, size_t n, char32_t c, size_t& i) {
+                constexpr size_t block = 16 / sizeof(Unit);
+                const __m128i key = splat<Unit>(c);
+                for (; n - i >= block; i += block) {
+                    uint32_t m = (uint32_t)_mm_movemask_epi8(equal<Unit>(_mm_loadu_si128((const __m128i*)(p + i)), key));
+                    if (m) { i += first_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+
+            template<typename Unit>
+            inline bool rfind_sse2(const Unit* p, char32_t c, size_t& end) {
+                constexpr size_t block = 16 / sizeof(Unit);
+                const __m128i key = splat<Unit>(c);
+                for (; end >= block; end -= block) {
+                    uint32_t m = (uint32_t)_mm_movemask_epi8(equal<Unit>(_mm_loadu_si128((const __m128i*)(p + end - block)), key));
+                    if (m) { end = end - block + last_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+
+            template<typename Unit>
+            inline size_t count_sse2(const Unit* p, size_t n, char32_t c, size_t& i) {
+                constexpr size_t block = 16 / sizeof(Unit);
+                const __m128i key = splat<Unit>(c);
+                size_t bytes = 0;
+                for (; n - i >= block; i += block) {
+                    bytes += utf::detail::popcount((uint32_t)_mm_movemask_epi8(equal<Unit>(_mm_loadu_si128((const __m128i*)(p + i)), key)));
+                }
+                return bytes / sizeof(Unit);
+            }
+
+            template<typename Unit>
+            inline size_t replace_sse2(Unit* p, size_t n, char32_t from, char32_t to, size_t& i) {
+                constexpr size_t block = 16 / sizeof(Unit);
+                const __m128i key = splat<Unit>(from), value = splat<Unit>(to);
+                size_t bytes = 0, j = i; // a local index: the stores below may alias i
+                for (; n - j >= block; j += block) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(p + j));
+                    __m128i hit = equal<Unit>(v, key);
+                    uint32_t m = (uint32_t)_mm_movemask_epi8(hit);
+                    if (!m) continue;
+                    bytes += utf::detail::popcount(m);
+                    _mm_storeu_si128((__m128i*)(p + j), _mm_or_si128(_mm_andnot_si128(hit, v), _mm_and_si128(hit, value)));
+                }
+                i = j;
+                return bytes / sizeof(Unit);
+            }
+
+            // Movemask of the units of the block at q that are (In) or are
+            // not (!In) in the set.
+            template<typename Unit, bool In>
+            inline uint32_t set_mask_sse2(const Unit* q, const __m128i* keys, size_t count) {
+                __m128i v = _mm_loadu_si128((const __m128i*)q), hit = _mm_setzero_si128();
+                for (size_t k = 0; k < count; ++k) hit = _mm_or_si128(hit, equal<Unit>(v, keys[k]));
+                uint32_t m = (uint32_t)_mm_movemask_epi8(hit);
+                return In ? m : ~m & 0xFFFF;
+            }
+
+            template<typename Unit>
+            inline size_t set_keys_sse2(const small_set& set, __m128i* keys) {
+                size_t count = 0;
+                for (size_t k = 0; k < set.size; ++k) {
+                    if (set.members[k] <= unit_max<Unit>()) keys[count++] = splat<Unit>(set.members[k]);
+                }
+                return count;
+            }
+
+            template<typename Unit, bool In>
+            inline bool find_set_sse2(const Unit* p, size_t n, const small_set& set, size_t& i) {
+                constexpr size_t block = 16 / sizeof(Unit);
+                __m128i keys[small_set::capacity];
+                size_t count = set_keys_sse2<Unit>(set, keys);
+                for (; n - i >= block; i += block) {
+                    uint32_t m = set_mask_sse2<Unit, In>(p + i, keys, count);
+                    if (m) { i += first_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+
+            template<typename Unit, bool In>
+            inline bool rfind_set_sse2(const Unit* p, const small_set& set, size_t& end) {
+                constexpr size_t block = 16 / sizeof(Unit);
+                __m128i keys[small_set::capacity];
+                size_t count = set_keys_sse2<Unit>(set, keys);
+                for (; end >= block; end -= block) {
+                    uint32_t m = set_mask_sse2<Unit, In>(p + end - block, keys, count);
+                    if (m) { end = end - block + last_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+
+            template<typename Unit>
+            inline bool mismatch_sse2(const Unit* a, const Unit* b, size_t n, size_t& i) {
+                constexpr size_t block = 16 / sizeof(Unit);
+                for (; n - i >= block; i += block) {
+                    __m128i x = _mm_loadu_si128((const __m128i*)(a + i)), y = _mm_loadu_si128((const __m128i*)(b + i));
+                    uint32_t m = ~(uint32_t)_mm_movemask_epi8(equal<Unit>(x, y)) & 0xFFFF;
+                    if (m) { i += first_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+#endif
+
+            //============================
+            // AVX2 kernels
+            //============================
+            // The same, 32 bytes at a time.
+#if defined(STDX_SCAN_AVX2)
+            template<typename Unit>
+            STDX_SCAN_AVX2_FN inline __m256i splat256(char32_t c) {
+                if constexpr (sizeof(Unit) == 1) return _mm256_set1_epi8((char)c);
+                else if constexpr (sizeof(Unit) == 2) return _mm256_set1_epi16((short)c);
+                else return _mm256_set1_epi32((int)c);
+            }
+
+            template<typename Unit>
+            STDX_SCAN_AVX2_FN inline __m256i equal256(__m256i a, __m256i b) {
+                if constexpr (sizeof(Unit) == 1) return _mm256_cmpeq_epi8(a, b);
+                else if constexpr (sizeof(Unit) == 2) return _mm256_cmpeq_epi16(a, b);
+                else return _mm256_cmpeq_epi32(a, b);
+            }
+
+            template<typename Unit>
+            STDX_SCAN_AVX2_FN inline bool find_avx2(const Unit* p, size_t n, char32_t c, size_t& i) {
+                constexpr size_t block = 32 / sizeof(Unit);
+                const __m256i key = splat256<Unit>(c);
+                // two blocks per test while the match is still far away
+                for (; n - i >= 2 * block; i += 2 * block) {
+                    __m256i a = equal256<Unit>(_mm256_loadu_si256((const __m256i*)(p + i)), key);
+                    __m256i b = equal256<Unit>(_mm256_loadu_si256((const __m256i*)(p + i + block)), key);
+                    if (_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) continue;
+                    uint32_t m = (uint32_t)_mm256_movemask_epi8(a);
+                    if (m) { i += first_lane<Unit>(m); return true; }
+                    i += block + first_lane<Unit>((uint32_t)_mm256_movemask_epi8(b));
+                    return true;
+                }
+                for (; n - i >= block; i += block) {
+                    uint32_t m = (uint32_t)_mm256_movemask_epi8(equal256<Unit>(_mm256_loadu_si256((const __m256i*)(p + i)), key));
+                    if (m) { i += first_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+
+            template<typename Unit>
+            STDX_SCAN_AVX2_FN inline bool rfind_avx2(const Unit* p, char32_t c, size_t& end) {
+                constexpr size_t block = 32 / sizeof(Unit);
+                const __m256i key = splat256<Unit>(c);
+                for (; end >= block; end -= block) {
+                    uint32_t m = (uint32_t)_mm256_movemask_epi8(equal256<Unit>(_mm256_loadu_si256((const __m256i*)(p + end - block)), key));
+                    if (m) { end = end - block + last_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+
+            template<typename Unit>
+            STDX_SCAN_AVX2_FN inline size_t count_avx2(const Unit* p, size_t n, char32_t c, size_t& i) {
+                constexpr size_t block = 32 / sizeof(Unit);
+                const __m256i key = splat256<Unit>(c);
+                size_t bytes = 0;
+                for (; n - i >= block; i += block) {
+                    bytes += utf::detail::popcount((uint32_t)_mm256_movemask_epi8(equal256<Unit>(_mm256_loadu_si256((const __m256i*)(p + i)), key)));
+                }
+                return bytes / sizeof(Unit);
+            }
+
+            template<typename Unit>
+            STDX_SCAN_AVX2_FN inline size_t replace_avx2(Unit* p, size_t n, char32_t from, char32_t to, size_t& i) {
+                constexpr size_t block = 32 / sizeof(Unit);
+                const __m256i key = splat256<Unit>(from), value = splat256<Unit>(to);
+                size_t bytes = 0, j = i; // a local index: the stores below may alias i
+                for (; n - j >= block; j += block) {
+                    __m256i v = _mm256_loadu_si256((const __m256i*)(p + j));
+                    __m256i hit = equal256<Unit>(v, key);
+                    uint32_t m = (uint32_t)_mm256_movemask_epi8(hit);
+                    if (!m) continue;
+                    bytes += utf::detail::popcount(m);
+                    _mm256_storeu_si256((__m256i*)(p + j), _mm256_blendv_epi8(v, value, hit));
+                }
+                i = j;
+                return bytes / sizeof(Unit);
+            }
+
+            template<typename Unit, bool In>
+            STDX_SCAN_AVX2_FN inline uint32_t set_mask_avx2(const Unit* q, const __m256i* keys, size_t count) {
+                __m256i v = _mm256_loadu_si256((const __m256i*)q), hit = _mm256_setzero_si256();
+                for (size_t k = 0; k < count; ++k) hit = _mm256_or_si256(hit, equal256<Unit>(v, keys[k]));
+                uint32_t m = (uint32_t)_mm256_movemask_epi8(hit);
+                return In ? m : ~m;
+            }
+
+            template<typename Unit>
+            STDX_SCAN_AVX2_FN inline size_t set_keys_avx2(const small_set& set, __m256i* keys) {
+                size_t count = 0;
+                for (size_t k = 0; k < set.size; ++k) {
+                    if (set.members[k] <= unit_max<Unit>()) keys[count++] = splat256<Unit>(set.members[k]);
+                }
+                return count;
+            }
+
+            template<typename Unit, bool In>
+            STDX_SCAN_AVX2_FN inline bool find_set_avx2(const Unit* p, size_t n, const small_set& set, size_t& i) {
+                constexpr size_t block = 32 / sizeof(Unit);
+                __m256i keys[small_set::capacity];
+                size_t count = set_keys_avx2<Unit>(set, keys);
+                for (; n - i >= block; i += block) {
+                    uint32_t m = set_mask_avx2<Unit, In>(p + i, keys, count);
+                    if (m) { i += first_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+
+            template<typename Unit, bool In>
+            STDX_SCAN_AVX2_FN inline bool rfind_set_avx2(const Unit* p, const small_set& set, size_t& end) {
+                constexpr size_t block = 32 / sizeof(Unit);
+                __m256i keys[small_set::capacity];
+                size_t count = set_keys_avx2<Unit>(set, keys);
+                for (; end >= block; end -= block) {
+                    uint32_t m = set_mask_avx2<Unit, In>(p + end - block, keys, count);
+                    if (m) { end = end - block + last_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+
+            template<typename Unit>
+            STDX_SCAN_AVX2_FN inline bool mismatch_avx2(const Unit* a, const Unit* b, size_t n, size_t& i) {
+                constexpr size_t block = 32 / sizeof(Unit);
+                for (; n - i >= block; i += block) {
+                    __m256i x = _mm256_loadu_si256((const __m256i*)(a + i)), y = _mm256_loadu_si256((const __m256i*)(b + i));
+                    uint32_t m = ~(uint32_t)_mm256_movemask_epi8(equal256<Unit>(x, y));
+                    if (m) { i += first_lane<Unit>(m); return true; }
+                }
+                return false;
+            }
+#endif
+
+            template<typename Unit, bool In>
+            inline size_t find_set(const Unit* p, size_t n, const small_set& set, size_t from) {
+                if (from >= n) return npos;
+                size_t i = from;
+                // most scans stop on the first unit (trim of untrimmed text)
+                if (set.contains((char32_t)p[i]) == In) return i;
+#if defined(STDX_SCAN_AVX2)
+                if (avx2() ? find_set_avx2<Unit, In>(p, n, set, i) : find_set_sse2<Unit, In>(p, n, set, i)) return i;
+#elif defined(STDX_UTF_SSE2)
+                if (find_set_sse2<Unit, In>(p, n, set, i)) return i;
+#endif
+                for (; i < n; ++i) {
+                    if (set.contains((char32_t)p[i]) == In) return i;
+                }
+                return npos;
+            }
+
+            template<typename Unit, bool In>
+            inline size_t rfind_set(const Unit* p, size_t n, const small_set& set) {
+                size_t end = n;
+                if (end > 0 && set.contains((char32_t)p[end - 1]) == In) return end - 1;
+#if defined(STDX_SCAN_AVX2)
+                if (avx2() ? rfind_set_avx2<Unit, In>(p, set, end) : rfind_set_sse2<Unit, In>(p, set, end)) return end;
+#elif defined(STDX_UTF_SSE2)
+                if (rfind_set_sse2<Unit, In>(p, set, end)) return end;
+#endif
+                while (end-- > 0) {
+                    if (set.contains((char32_t)p[end]) == In) return end;
+                }
+                return npos;
+            }
+        }
+
+        //============================
+        // Kernels
+        //============================
+        // Unit is unsigned char, char16_t or char32_t: one stdx::string
+        // storage width each. Code points wider than the units never match.
+
+        // First index at or after from holding c, or npos.
+        template<typename Unit>
+        inline size_t find(const Unit* p, size_t n, char32_t c, size_t from = 0) {
+            if (c > detail::unit_max<Unit>() || from >= n) return npos;
+            if constexpr (sizeof(Unit) == 1) {
+                // the C library's memchr is already vectorized and dispatched
+                const void* hit = memchr(p + from, (int)c, n - from);
+                return hit ? (size_t)((const Unit*)hit - p) : npos;
+            }
+            else {
+                size_t i = from;
+#if defined(STDX_SCAN_AVX2)
+                if (detail::avx2() ? detail::find_avx2(p, n, c, i) : detail::find_sse2(p, n, c, i)) return i;
+#elif defined(STDX_UTF_SSE2)
+                if (detail::find_sse2(p, n, c, i)) return i;
+#endif
+                for (; i < n; ++i) {
+                    if (p[i] == (Unit)c) return i;
+                }
+                return npos;
+            }
+        }
+
+        // Last index holding c, or npos.
+        template<typename Unit>
+        inline size_t rfind(const Unit* p, size_t n, char32_t c) {
+            if (c > detail::unit_max<Unit>()) return npos;
+            size_t end = n;
+#if defined(STDX_SCAN_AVX2)
+            if (detail::avx2() ? detail::rfind_avx2(p, c, end) : detail::rfind_sse2(p, c, end)) return end;
+#elif defined(STDX_UTF_SSE2)
+            if (detail::rfind_sse2(p, c, end)) return end;
+#endif
+            while (end-- > 0) {
+                if (p[end] == (Unit)c) return end;
+            }
+            return npos;
+        }
+
+        template<typename Unit>
+        inline size_t count(const Unit* p, size_t n, char32_t c) {
+            if (c > detail::unit_max<Unit>()) return 0;
+            size_t i = 0, hits = 0;
+#if defined(STDX_SCAN_AVX2)
+            hits = detail::avx2() ? detail::count_avx2(p, n, c, i) : detail::count_sse2(p, n, c, i);
+#elif defined(STDX_UTF_SSE2)
+            hits = detail::count_sse2(p, n, c, i);
+#endif
+            for (const Unit* q = p + i; q < p + n; ++q) hits += *q == (Unit)c;
+            return hits;
+        }
+
+        // Overwrites every from with to (which must fit a Unit) and returns
+        // how many there were. Blocks without a match are not written.
+        template<typename Unit>
+        inline size_t replace(Unit* p, size_t n, char32_t from, char32_t to) {
+            if (from > detail::unit_max<Unit>()) return 0;
+            size_t i = 0, hits = 0;
+#if defined(STDX_SCAN_AVX2)
+            hits = detail::avx2() ? detail::replace_avx2(p, n, from, to, i) : detail::replace_sse2(p, n, from, to, i);
+#elif defined(STDX_UTF_SSE2)
+            hits = detail::replace_sse2(p, n, from, to, i);
+#endif
+            for (Unit* q = p + i; q < p + n; ++q) {
+                if (*q == (Unit)from) { *q = (Unit)to; ++hits; }
+            }
+            return hits;
+        }
+
+        // First index at or after from whose unit is (find_any) or is not
+        // (find_not) in set, or npos; rfind_not is the last one not in set.
+        template<typename Unit>
+        inline size_t find_any(const Unit* p, size_t n, const small_set& set, size_t from = 0) {
+            return detail::find_set<Unit, true>(p, n, set, from);
+        }
+
+        template<typename Unit>
+        inline size_t find_not(const Unit* p, size_t n, const small_set& set, size_t from = 0) {
+            return detail::find_set<Unit, false>(p, n, set, from);
+        }
+
+        template<typename Unit>
+        inline size_t rfind_not(const Unit* p, size_t n, const small_set& set) {
+            return detail::rfind_set<Unit, false>(p, n, set);
+        }
+
+        // First index below n where a and b differ, or n.
+        template<typename Unit>
+        inline size_t mismatch(const Unit* a, const Unit* b, size_t n) {
+            size_t i = 0;
+#if defined(STDX_SCAN_AVX2)
+            if (detail::avx2() ? detail::mismatch_avx2(a, b, n, i) : detail::mismatch_sse2(a, b, n, i)) return i;
+#elif defined(STDX_UTF_SSE2)
+            if (detail::mismatch_sse2(a, b, n, i)) return i;
+#endif
+            while (i < n && a[i] == b[i]) ++i;
+            return i;
+        }
+
+        // Whether the AVX2 kernels may be picked on a CPU that has them.
+        // Turning them off runs the SSE2 ones instead, e.g. to compare the
+        // two tiers. Safe to call while other threads scan.
+#if defined(STDX_SCAN_AVX2)
+        inline void allow_avx2(bool allowed) { detail::avx2_allowed().store(allowed, std::memory_order_relaxed); }
+        inline bool uses_avx2() { return detail::avx2(); }
+#else
+        inline void allow_avx2(bool) {}
+        inline bool uses_avx2() { return false; }
+#endif
+    }
+}
\ No newline at end of file
@@ -0,0 +1,479 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include "stdxutf.h"
+
+namespace stdx {
+    namespace search {
+        static constexpr size_t npos = (size_t)-1;
+
+        namespace detail {
+            // Needles at most this long use the first/last-unit filter (or
+            // Horspool without SIMD); longer ones use Two-Way, which stays
+            // linear however repetitive the text is.
+            static constexpr size_t short_needle = 32;
+
+            // Reads a sequence back to front so rfind can reuse the forward
+            // searchers on the reversed haystack and needle.
+            template<typename Unit>
+            struct reversed {
+                const Unit* p;
+                size_t n;
+                inline char32_t operator[](size_t i) const { return (char32_t)p[n - 1 - i]; }
+            };
+
+            template<typename Unit>
+            inline constexpr char32_t unit_max() {
+                return sizeof(Unit) == 1 ? 0xFF : sizeof(Unit) == 2 ? 0xFFFF : 0xFFFFFFFF;
+            }
+
+            template<typename H, typename N>
+            inline bool equal_at(const H& h, size_t pos, const N& x, size_t from, size_t to) {
+                for (size_t i = from; i < to; ++i) {
+                    if ((char32_t)h[pos + i] != (char32_t)x[i]) return false;
+                }
+                return true;
+            }
+
+#if defined(STDX_UTF_SSE2)
+            template<typename Unit>
+            inline __m128i splat(char32_t c) {
+                if constexpr (sizeof(Unit) == 1) return _mm_set1_epi8((char)c);
+                else if constexpr (sizeof(Unit) == 2) return _mm_set1_epi16((short)c);
+                else return _mm_set1_epi32((int)c);
+            }
+
+            template<typename Unit>
+            inline __m128i equal_lanes(__m128i a, __m128i b) {
+                if constexpr (sizeof(Unit) == 1) return _mm_cmpeq_epi8(a, b);
+                else if constexpr (sizeof(Unit) == 2) return _mm_cmpeq_epi16(a, b);
+                else return _mm_cmpeq_epi32(a, b);
+            }
+#endif
+#if defined(STDX_UTF_AVX2)
+            template<typename Unit>
+            inline __m256i splat256(char32_t c) {
+                if constexpr (sizeof(Unit) == 1) return _mm256_set1_epi8((char)c);
+                else if constexpr (sizeof(Unit) == 2) return _mm256_set1_epi16((short)c);
+                else return _mm256_set1_epi32((int)c);
+            }
+
+            template<typename Unit>
+            inline __m256i equal_lanes256(__m256i a, __m256i b) {
+                if constexpr (sizeof(Unit) == 1) return _mm256_cmpeq_epi8(a, b);
+                else if constexpr (sizeof(Unit) == 2) return _mm256_cmpeq_epi16(a, b);
+                else return _mm256_cmpeq_epi32(a, b);
+            }
+#endif
+
+            // One bit per unit of a byte-granular movemask.
+            template<typename Unit>
+            inline constexpr uint32_t lane_bits() {
+                return sizeof(Unit) == 1 ? 0xFFFFFFFFu : sizeof(Unit) == 2 ? 0x55555555u : 0x11111111u;
+            }
+        }
+
+        //============================
+        // Searcher
+        //============================
+        // Preprocesses a needle once so it can be looked up in any number of
+        // haystacks, of any unit width. N is a unit pointer or a reversed<>
+        // view; the needle must outlive the searcher.
+        template<typename N>
+        class searcher {
+        public:
+            searcher(N needle, size_t m) : m_needle(needle), m_len(m) {
+                char32_t bits = 0;
+                for (size_t i = 0; i < m; ++i) bits |= (char32_t)needle[i];
+                m_bits = bits;
+                if (m < 2) return;
+
+                // bad-character shifts keyed on the low byte; code points that
+                // share a low byte share the smaller (safe) shift
+                if (m <= detail::short_needle) {
+                    for (size_t i = 0; i < 256; ++i) m_shift[i] = m;
+                    for (size_t i = 0; i + 1 < m; ++i) m_shift[(char32_t)needle[i] & 0xFF] = m - 1 - i;
+                    return;
+                }
+                for (size_t i = 0; i < 256; ++i) m_shift[i] = 0;
+                for (size_t i = 0; i < m; ++i) m_shift[(char32_t)needle[i] & 0xFF] = i + 1;
+
+                // critical factorization (Crochemore-Perrin)
+                size_t p0, p1;
+                size_t ms0 = maximal_suffix(m, p0, false);
+                size_t ms1 = maximal_suffix(m, p1, true);
+                m_split = ms1 + 1 > ms0 + 1 ? ms1 : ms0;
+                m_period = ms1 + 1 > ms0 + 1 ? p1 : p0;
+                if (detail::equal_at(m_needle, m_period, m_needle, 0, m_split + 1)) {
+                    m_memory = m - m_period;
+                }
+                else {
+                    m_memory = 0;
+                    m_period = std::max(m_split, m - m_split - 1) + 1;
+                }
+            }
+
+            inline size_t size() const { return m_len; }
+
+            // First match at or after from, or npos.
+            template<typename H>
+            size_t find(const H& hay, size_t n, size_t from = 0) const {
+                if (m_len == 0) return from <= n ? from : npos;
+                if (from > n || n - from < m_len) return npos;
+                if constexpr (std::is_pointer_v<H>) {
+                    // nothing wider than the haystack's units can be in it
+                    using Unit = std::remove_cv_t<std::remove_pointer_t<H>>;
+                    if (m_bits > detail::unit_max<Unit>()) return npos;
+                    if (m_len == 1) return find_unit(hay, n, from);
+#if defined(STDX_UTF_SSE2)
+                    if (m_len <= detail::short_needle) return first_last(hay, n, from);
+#endif
+                }
+                else {
+                    if (m_len == 1) return find_one(hay, n, from);
+                }
+                if (m_len <= detail::short_needle) return horspool(hay, n, from);
+                return two_way(hay, n, from);
+            }
+
+        private:
+            N m_needle;
+            size_t m_len;
+            char32_t m_bits = 0;
+            size_t m_split = 0;
+            size_t m_period = 0;
+            size_t m_memory = 0;
+            size_t m_shift[256];
+
+            size_t maximal_suffix(size_t m, size_t& period, bool flip) const {
+                const N& x = m_needle;
+                size_t ip = (size_t)-1, jp = 0, k = 1, p = 1;
+                while (jp + k < m) {
+                    char32_t a = (char32_t)x[ip + k], b = (char32_t)x[jp + k];
+                    if (a == b) {
+                        if (k == p) { jp += p; k = 1; }
+                        else k++;
+                    }
+                    else if (flip ? a < b : a > b) { jp += k; k = 1; p = jp - ip; }
+                    else { ip = jp++; k = p = 1; }
+                }
+                period = p;
+                return ip;
+            }
+
+            template<typename Unit>
+            size_t find_unit(const Unit* hay, size_t n, size_t from) const {
+                Unit c = (Unit)m_needle[0];
+                if constexpr (sizeof(Unit) == 1) {
+                    const void* hit = memchr(hay + from, c, n - from);
+                    return hit ? (size_t)((const Unit*)hit - hay) : npos;
+                }
+                else {
+                    for (size_t i = from; i < n; ++i) {
+                        if (hay[i] == c) return i;
+                    }
+                    return npos;
+                }
+            }
+
+            template<typename H>
+            size_t find_one(const H& hay, size_t n, size_t from) const {
+                char32_t c = (char32_t)m_needle[0];
+                for (size_t i = from; i < n; ++i) {
+                    if ((char32_t)hay[i] == c) return i;
+                }
+                return npos;
+            }
+
+            template<typename H>
+            size_t horspool(const H& hay, size_t n, size_t pos) const {
+                size_t m = m_len;
+                char32_t last = (char32_t)m_needle[m - 1];
+                while (n - pos >= m) {
+                    char32_t c = (char32_t)hay[pos + m - 1];
+                    if (c == last && detail::equal_at(hay, pos, m_needle, 0, m - 1)) return pos;
+                    pos += m_shift[c & 0xFF];
+                }
+                return npos;
+            }
+
+#if defined(STDX_UTF_SSE2)
+            // Compares the first and last needle units against a whole vector
+            // of candidate positions at once and verifies only the survivors.
+            template<typename Unit>
+            size_t first_last(const Unit* hay, size_t n, size_t pos) const {
+                size_t m = m_len;
+                char32_t first = (char32_t)m_needle[0], last = (char32_t)m_needle[m - 1];
+                auto verify = [&](uint32_t mask, size_t base) -> size_t {
+                    mask &= detail::lane_bits<Unit>();
+                    while (mask) {
+                        size_t i = base + utf::detail::ctz(mask) / sizeof(Unit);
+                        if (detail::equal_at(hay, i, m_needle, 1, m - 1)) return i;
+                        mask &= mask - 1;
+                    }
+                    return npos;
+                };
+#if defined(STDX_UTF_AVX2)
+                {
+                    constexpr size_t lanes = 32 / sizeof(Unit);
+                    const __m256i vf = detail::splat256<Unit>(first), vl = detail::splat256<Unit>(last);
+                    for (; n - pos >= m - 1 + lanes; pos += lanes) {
+                        __m256i a = detail::equal_lanes256<Unit>(_mm256_loadu_si256((const __m256i*)(hay + pos)), vf);
+                        __m256i b = detail::equal_lanes256<Unit>(_mm256_loadu_si256((const __m256i*)(hay + pos + m - 1)), vl);
+                        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(a, b));
+                        if (mask) {
+                            size_t hit = verify(mask, pos);
+                            if (hit != npos) return hit;
+                        }
+                    }
+                }
+#endif
+#if defined(STDX_UTF_SSE2)
+                {
+                    constexpr size_t lanes = 16 / sizeof(Unit);
+                    const __m128i vf = detail::splat<Unit>(first), vl = detail::splat<Unit>(last);
+                    for (; n - pos >= m - 1 + lanes; pos += lanes) {
+                        __m128i a = detail::equal_lanes<Unit>(_mm_loadu_si128((const __m128i*)(hay + pos)), vf);
+                        __m128i b = detail::equal_lanes<Unit>(_mm_loadu_si128((const __m128i*)(hay + pos + m - 1)), vl);
+                        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(a, b));
+                        if (mask) {
+                            size_t hit = verify(mask, pos);
+                            if (hit != npos) return hit;
+                        }
+                    }
+                }
+#endif
+                return horspool(hay, n, pos);
+            }
+#endif
+
+            // Two-Way with a bad-character shift on the window's last unit.
+            template<typename H>
+            size_t two_way(const H& hay, size_t n, size_t pos) const {
+                const N& x = m_needle;
+                size_t m = m_len, ms = m_split, mem = 0;
+                while (n - pos >= m) {
+                    char32_t c = (char32_t)hay[pos + m - 1];
+                    size_t k = m - m_shift[c & 0xFF];
+                    if (k) {
+                        // c is not the needle's last unit
+                        pos += k < mem ? mem : k;
+                        mem = 0;
+                        continue;
+                    }
+                    k = std::max(ms + 1, mem);
+                    while (k < m && (char32_t)x[k] == (char32_t)hay[pos + k]) k++;
+                    if (k < m) {
+                        pos += k - ms;
+                        mem = 0;
+                        continue;
+                    }
+                    k = ms + 1;
+                    while (k > mem && (char32_t)x[k - 1] == (char32_t)hay[pos + k - 1]) k--;
+                    if (k <= mem) return pos;
+                    pos += m_period;
+                    mem = m_memory;
+                }
+                return npos;
+            }
+        };
+
+        //============================
+        // Free functions
+        //============================
+        template<typename A, typename B>
+        inline size_t find(const A* hay, size_t n, const B* needle, size_t m, size_t from = 0) {
+            return searcher<const B*>(needle, m).find(hay, n, from);
+        }
+
+        // Last match starting at or before n - m, or npos.
+        template<typename A, typename B>
+        inline size_t rfind(const A* hay, size_t n, const B* needle, size_t m) {
+            if (m > n) return npos;
+            if (m == 0) return n;
+            size_t hit = searcher<detail::reversed<B>>(detail::reversed<B>{ needle, m }, m)
+                .find(detail::reversed<A>{ hay, n }, n);
+            return hit == npos ? npos : n - m - hit;
+        }
+
+        // Calls f(pos) for every non-overlapping match, left to right, and
+        // returns how many there were.
+        template<typename A, typename B, typename F>
+        inline size_t find_all(const A* hay, size_t n, const B* needle, size_t m, F&& f) {
+            if (m == 0) return 0;
+            searcher<const B*> s(needle, m);
+            size_t count = 0;
+            for (size_t pos = s.find(hay, n, 0); pos != npos; pos = s.find(hay, n, pos + m)) {
+                f(pos);
+                ++count;
+            }
+            return count;
+        }
+
+        //============================
+        // Multi-pattern matcher
+        //============================
+        struct match {
+            size_t pos = npos;
+            size_t length = 0;
+            size_t pattern = npos; // index into the patterns the matcher was built from
+
+            explicit operator bool() const { return pos != npos; }
+        };
+
+        // Aho-Corasick automaton compiled once from a list of patterns; a scan
+        // costs one transition per code point however many patterns there are.
+        // Matches are leftmost-longest, as the first of a chain of replace()
+        // calls would see them with the longest pattern first: the match that
+        // starts earliest wins, and of those the longest. Scanning resumes
+        // after the match (non-overlapping).
+        class matcher {
+        public:
+            matcher() { build({}); }
+
+            // Range of code-point sequences: stdx::string, string_view,
+            // std::u32string, ... Empty patterns keep their index but never match.
+            template<typename Range>
+            explicit matcher(const Range& patterns) {
+                std::vector<std::vector<std::pair<char32_t, uint32_t>>> trie(1);
+                std::vector<uint32_t> terminal(1, none);
+                for (const auto& pattern : patterns) {
+                    uint32_t s = 0;
+                    size_t len = 0;
+                    for (char32_t c : pattern) {
+                        uint32_t t = none;
+                        for (const auto& e : trie[s]) {
+                            if (e.first == c) { t = e.second; break; }
+                        }
+                        if (t == none) {
+                            t = (uint32_t)trie.size();
+                            trie[s].emplace_back(c, t);
+                            trie.emplace_back();
+                            terminal.push_back(none);
+                        }
+                        s = t;
+                        ++len;
+                    }
+                    if (len && terminal[s] == none) terminal[s] = (uint32_t)m_lengths.size();
+                    m_lengths.push_back(len);
+                }
+                m_nodes.resize(trie.size());
+                for (size_t i = 0; i < trie.size(); ++i) {
+                    std::sort(trie[i].begin(), trie[i].end());
+                    m_nodes[i].first_edge = (uint32_t)m_edges.size();
+                    m_nodes[i].edge_count = (uint32_t)trie[i].size();
+                    m_edges.insert(m_edges.end(), trie[i].begin(), trie[i].end());
+                }
+                build(terminal);
+            }
+
+            // Number of patterns, including empty ones.
+            inline size_t size() const { return m_lengths.size(); }
+
+            // Leftmost-longest match at or after from, or a match whose pos is npos.
+            template<typename Unit>
+            match find(const Unit* hay, size_t n, size_t from = 0) const {
+                uint32_t s = 0;
+                match best;
+                for (size_t i = from; i < n; ++i) {
+                    if (s == 0) {
+                        if (best) break;
+                        // at the root, skip units that cannot start a pattern
+                        while (i < n && (char32_t)hay[i] < 256 && m_root[(char32_t)hay[i]] == 0) ++i;
+                        if (i == n) break;
+                    }
+                    s = next(s, (char32_t)hay[i]);
+                    // the state spells hay[i + 1 - depth, i]: once that starts
+                    // after the best match, nothing later can start earlier
+                    if (best && i + 1 - m_nodes[s].depth > best.pos) break;
+                    uint32_t p = m_nodes[s].out;
+                    if (p == none) continue;
+                    // the longest pattern ending here starts earliest
+                    match m{ i + 1 - m_lengths[p], m_lengths[p], p };
+                    if (!best || m.pos < best.pos || (m.pos == best.pos && m.length > best.length)) best = m;
+                }
+                return best;
+            }
+
+            // Calls f(match) for every non-overlapping match and returns the count.
+            template<typename Unit, typename F>
+            size_t find_all(const Unit* hay, size_t n, F&& f) const {
+                size_t count = 0;
+                for (match m = find(hay, n, 0); m; m = find(hay, n, m.pos + m.length)) {
+                    f(m);
+                    ++count;
+                }
+                return count;
+            }
+
+        private:
+            static constexpr uint32_t none = (uint32_t)-1;
+
+            struct node {
+                uint32_t first_edge = 0;
+                uint32_t edge_count = 0;
+                uint32_t fail = 0;
+                uint32_t out = none; // longest pattern that is a suffix of this state
+                uint32_t depth = 0;  // code points from the root
+            };
+
+            std::vector<node> m_nodes;
+            std::vector<std::pair<char32_t, uint32_t>> m_edges; // sorted per node
+            std::vector<size_t> m_lengths;
+            uint32_t m_root[256]; // root transitions for Latin-1, the common case
+
+            inline uint32_t edge(uint32_t s, char32_t c) const {
+                const node& nd = m_nodes[s];
+                auto first = m_edges.begin() + nd.first_edge, last = first + nd.edge_count;
+                if (nd.edge_count <= 8) {
+                    for (; first != last; ++first) {
+                        if (first->first == c) return first->second;
+                    }
+                    return none;
+                }
+                auto it = std::lower_bound(first, last, std::make_pair(c, (uint32_t)0));
+                return it != last && it->first == c ? it->second : none;
+            }
+
+            inline uint32_t next(uint32_t s, char32_t c) const {
+                for (;;) {
+                    if (s == 0) {
+                        if (c < 256) return m_root[c];
+                        uint32_t t = edge(0, c);
+                        return t == none ? 0 : t;
+                    }
+                    uint32_t t = edge(s, c);
+                    if (t != none) return t;
+                    s = m_nodes[s].fail;
+                }
+            }
+
+            // Failure links and outputs, breadth first from the root.
+            void build(const std::vector<uint32_t>& terminal) {
+                if (m_nodes.empty()) m_nodes.resize(1);
+                for (uint32_t c = 0; c < 256; ++c) {
+                    uint32_t t = edge(0, c);
+                    m_root[c] = t == none ? 0 : t;
+                }
+                std::vector<uint32_t> queue(1, 0);
+                for (size_t qi = 0; qi < queue.size(); ++qi) {
+                    uint32_t u = queue[qi];
+                    const node& nu = m_nodes[u];
+                    for (uint32_t e = nu.first_edge; e < nu.first_edge + nu.edge_count; ++e) {
+                        char32_t c = m_edges[e].first;
+                        uint32_t v = m_edges[e].second;
+                        m_nodes[v].depth = m_nodes[u].depth + 1;
+                        m_nodes[v].fail = u == 0 ? 0 : next(m_nodes[u].fail, c);
+                        m_nodes[v].out = terminal[v] != none ? terminal[v] : m_nodes[m_nodes[v].fail].out;
+                        queue.push_back(v);
+                    }
+                }
+            }
+        };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <new>
+#include <utility>
+#include "stdxstring.h"
+
+namespace stdx {
+    namespace detail {
+        // One allocation: this header, then the code points at the narrowest
+        // width that holds them, then a terminator.
+        struct shared_block {
+            std::atomic<size_t> refs;
+            size_t size;
+            size_t width;
+            size_t hash;
+
+            inline unsigned char* units() { return (unsigned char*)(this + 1); }
+        };
+    }
+
+    //============================
+    // shared_string (immutable, reference-counted)
+    //============================
+    // Frozen text for fan-out: copies share one buffer and cost an atomic
+    // increment, not an allocation. substr() shares the parent's buffer too.
+    // There is nothing to write through; str() gives a mutable stdx::string
+    // when one is needed. The hash of a whole frozen string is computed
+    // once, when it is frozen.
+    class shared_string {
+    public:
+        static constexpr size_t npos = (size_t)-1;
+
+        shared_string() = default;
+
+        explicit shared_string(string_view s) { freeze(s); }
+        explicit shared_string(const stdx::string& s) { freeze(s.view()); }
+
+        shared_string(const shared_string& other) noexcept
+            : m_block(other.m_block), m_offset(other.m_offset), m_size(other.m_size) {
+            if (m_block) m_block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        shared_string(shared_string&& other) noexcept
+            : m_block(std::exchange(other.m_block, nullptr)), m_offset(std::exchange(other.m_offset, 0)), m_size(std::exchange(other.m_size, 0)) {}
+
+        shared_string& operator=(shared_string other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~shared_string() { release(); }
+
+        inline void swap(shared_string& other) noexcept {
+            std::swap(m_block, other.m_block);
+            std::swap(m_offset, other.m_offset);
+            std::swap(m_size, other.m_size);
+        }
+
+        inline string_view view() const {
+            if (!m_block) return string_view();
+            return string_view(m_block->units() + m_offset * m_block->width, m_size, (unsigned)m_block->width);
+        }
+
+        operator string_view() const { return view(); }
+
+        inline size_t size() const { return m_size; }
+        inline size_t length() const { return m_size; }
+        inline bool empty() const { return m_size == 0; }
+        inline size_t width() const { return m_block ? m_block->width : 1; }
+        inline char32_t operator[](size_t index) const { return view()[index]; }
+
+        // Number of shared_strings (substrings included) sharing the buffer.
+        inline size_t use_count() const { return m_block ? m_block->refs.load(std::memory_order_relaxed) : 0; }
+
+        // Shares this buffer; no code points are copied.
+        inline shared_string substr(size_t pos, size_t len = npos) const {
+            shared_string result(*this);
+            if (pos > m_size) pos = m_size;
+            result.m_offset += pos;
+            result.m_size = std::min(len, m_size - pos);
+            return result;
+        }
+
+        // A mutable copy.
+        inline stdx::string str() const { return stdx::string(view()); }
+
+        // Same value as the text's stdx::string::hash().
+        inline size_t hash() const { return whole() ? m_block->hash : view().hash(); }
+
+        inline bool operator==(const shared_string& rhs) const {
+            if (m_size != rhs.m_size) return false;
+            if (m_block == rhs.m_block && m_offset == rhs.m_offset) return true;
+            if (whole() && rhs.whole() && m_block->hash != rhs.m_block->hash) return false;
+            return view() == rhs.view();
+        }
+
+        inline bool operator!=(const shared_string& rhs) const { return !(*this == rhs); }
+        inline bool operator==(string_view rhs) const { return view() == rhs; }
+        inline bool operator!=(string_view rhs) const { return !(view() == rhs); }
+        inline bool operator==(const stdx::string& rhs) const { return view() == rhs.view(); }
+        inline bool operator!=(const stdx::string& rhs) const { return !(view() == rhs.view()); }
+
+    private:
+        detail::shared_block* m_block = nullptr; // nullptr: empty
+        size_t m_offset = 0;
+        size_t m_size = 0;
+
+        inline bool whole() const { return m_block && m_offset == 0 && m_size == m_block->size; }
+
+        inline void freeze(string_view s) {
+            if (s.empty()) return;
+            unsigned width = s.needed_width();
+            void* memory = ::operator new(sizeof(detail::shared_block) + (s.size() + 1) * width);
+            m_block = new (memory) detail::shared_block{ { 1 }, s.size(), width, s.hash() };
+            s.visit([&](const auto* src) {
+                detail::visit_units(m_block->units(), width, [&](auto* dst) {
+                    detail::copy_units(dst, src, s.size());
+                    dst[s.size()] = 0;
+                });
+            });
+            m_size = s.size();
+        }
+
+        inline void release() {
+            if (m_block && m_block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                m_block->~shared_block();
+                ::operator delete(m_block);
+            }
+            m_block = nullptr;
+        }
+    };
+
+    inline void swap(shared_string& a, shared_string& b) noexcept { a.swap(b); }
+}
+
+namespace std {
+    template<>
+    struct hash<stdx::shared_string> {
+        inline size_t operator()(const stdx::shared_string& s) const { return s.hash(); }
+    };
+}
\ No newline at end of file
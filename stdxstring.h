@@ -2,665 +2,1923 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <new>
+#include <atomic>
+#include <memory>
+#include <iterator>
+#include <algorithm>
 #include <type_traits>
+#include <stdexcept>
+#include <charconv>
+#include <optional>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cmath>
+#include <limits>
+#include <memory_resource>
+#include "stdxutf.h"
+#include "stdxsearch.h"
+#include "stdxcase.h"
+#include "stdxhash.h"
+#include "stdxscan.h"
+
+#if defined(__cpp_impl_three_way_comparison) && __cpp_impl_three_way_comparison >= 201907L && __has_include(<compare>)
+#   include <compare>
+#   define STDX_STRING_THREE_WAY 1
+#endif
 
-namespace stdx {
-    //============================
-    // Utility methods
-    //============================
-    class string {
-    public:
-        string() = default;
-
-        string(const char* s) { fromUtf8(std::string(s)); }
-        string(const std::string& s) { fromUtf8(s); }
-        string(const wchar_t* s) { fromWstr(std::wstring(s)); }
-        string(const std::wstring& s) { fromWstr(s); }
-        string(const std::u32string& s) : data(s.begin(), s.end()) {}
+// Floating-point std::to_chars / std::from_chars where the library has
+// them, else printf / strtod (as stdxout.h decides it, so both headers
+// take the same path). Defining STDX_NO_FLOAT_TO_CHARS takes the fallback
+// anyway, so it can be tested on a library that has both.
+#if !defined(STDX_FLOAT_TO_CHARS) && defined(__cpp_lib_to_chars) && !defined(STDX_NO_FLOAT_TO_CHARS)
+#   define STDX_FLOAT_TO_CHARS 1
+#endif
 
-        operator std::string() const { return toUtf8(); }
-        operator std::wstring() const { return toWstr(); }
+namespace stdx {
+    namespace detail {
+        //============================
+        // Storage tiers
+        //============================
+        // A stdx::string keeps one code point per fixed-width unit: Latin-1
+        // (1 byte), UCS-2 (2 bytes) or UTF-32 (4 bytes), picked from the
+        // widest code point it holds. The templates below take any of the
+        // three unit types so each width gets its own specialised loop.
+        static constexpr size_t npos = (size_t)-1;
 
-		inline size_t size() const { return data.size(); }
-		inline bool empty() const { return data.empty(); }
+        constexpr unsigned width_for(char32_t bits) {
+            return bits <= 0xFF ? 1 : bits <= 0xFFFF ? 2 : 4;
+        }
 
-        struct utf8_t {};
-        struct utf16_t {};
-        struct utf32_t {};
-        template<typename Encoding>
-        auto c_str() const
-        {
-            static_assert(std::is_same_v<Encoding, utf8_t> ||
-                          std::is_same_v<Encoding, utf16_t> ||
-                          std::is_same_v<Encoding, utf32_t>,
-				"Unsupported encoding type");
+        template<typename Unit>
+        inline constexpr char32_t unit_max() {
+            return sizeof(Unit) == 1 ? 0xFF : sizeof(Unit) == 2 ? 0xFFFF : 0xFFFFFFFF;
+        }
 
-            return select_cstr(static_cast<Encoding*>(nullptr));
+        // OR of every code point; width_for() of the result is the narrowest fit.
+        template<typename Unit>
+        inline char32_t code_point_bits(const Unit* p, size_t n) {
+            char32_t bits = 0;
+            for (size_t i = 0; i < n; ++i) bits |= (char32_t)p[i];
+            return bits;
         }
 
-		inline void clear() { data.clear(); }
-		inline void push_back(char32_t c) { data.push_back(c); }
-        inline void push_back(char c) {
-            if ((unsigned char)c < 0x80) {
-                data.push_back((char32_t)c);
+        template<typename F>
+        inline decltype(auto) visit_units(unsigned char* p, unsigned width, F&& f) {
+            switch (width) {
+            case 1: return f((unsigned char*)p);
+            case 2: return f((char16_t*)p);
+            default: return f((char32_t*)p);
             }
-        }
-        inline void push_back(wchar_t c) {
-#ifdef _WIN32
-            // cannot append a lone high surrogate
-            if (c >= 0xD800 && c <= 0xDBFF) return; // invalid alone
-            if (c >= 0xDC00 && c <= 0xDFFF) return; // invalid alone
-            data.push_back((char32_t)c);
-#else
-            data.push_back((char32_t)c);
-#endif
         }
 
-		inline char32_t& back() { return data.back(); }
-
-		inline void append(const stdx::string& other) {
-            data.insert(data.end(), other.data.begin(), other.data.end());
-        }
-        inline void append(const std::string& other) {
-            auto u = utf8_to_utf32(other);
-            data.insert(data.end(), u.begin(), u.end());
-        }
-        inline void append(const std::wstring& other)
-        {
-#ifdef _WIN32
-            std::u32string u = utf16_to_utf32(
-                std::u16string(other.begin(), other.end())
-            );
-            data.insert(data.end(), u.begin(), u.end());
-#else
-            data.insert(data.end(), other.begin(), other.end());
-#endif
+        template<typename F>
+        inline decltype(auto) visit_units(const unsigned char* p, unsigned width, F&& f) {
+            switch (width) {
+            case 1: return f((const unsigned char*)p);
+            case 2: return f((const char16_t*)p);
+            default: return f((const char32_t*)p);
+            }
         }
 
-		inline void resize(size_t newSize) { data.resize(newSize); }
-
-        inline stdx::string substr(size_t pos, size_t len) const {
-            stdx::string result;
-            if (pos < data.size()) {
-                size_t rlen = std::min(len, data.size() - pos);
-                result.data.assign(data.begin() + pos, data.begin() + pos + rlen);
+        // Destination must be wide enough for every code point in src.
+        template<typename Dst, typename Src>
+        inline void copy_units(Dst* dst, const Src* src, size_t n) {
+            if constexpr (std::is_same_v<Dst, Src>) {
+                if (n) memmove(dst, src, n * sizeof(Dst));
             }
-            return result;
-		}
+            else {
+                for (size_t i = 0; i < n; ++i) dst[i] = (Dst)(char32_t)src[i];
+            }
+        }
 
-        inline stdx::string to_upper() const {
-            stdx::string result = *this;
-            for (auto& c : result.data) {
-                if (c >= U'a' && c <= U'z') {
-                    c = c - U'a' + U'A';
-                }
+        template<typename Unit>
+        inline void fill_units(Unit* dst, char32_t c, size_t n) {
+            if constexpr (sizeof(Unit) == 1) {
+                if (n) memset(dst, (int)c, n);
             }
-            return result;
-		}
+            else {
+                for (size_t i = 0; i < n; ++i) dst[i] = (Unit)c;
+            }
+        }
 
-        inline stdx::string to_lower() const {
-            stdx::string result = *this;
-            for (auto& c : result.data) {
-                if (c >= U'A' && c <= U'Z') {
-                    c = c - U'A' + U'a';
+        // Hashes code points rather than storage: units are narrowed to the
+        // smallest width that holds them, so equal strings hash alike whatever
+        // width each one happens to be stored at.
+        template<typename Unit>
+        inline uint64_t hash_code_points(const Unit* p, size_t n) {
+            unsigned width = sizeof(Unit) == 1 ? 1 : width_for(code_point_bits(p, n));
+            if (width == sizeof(Unit)) return hashing::hash_bytes(p, n * sizeof(Unit));
+            hashing::hasher h;
+            auto narrow = [&](auto unit) {
+                decltype(unit) chunk[256];
+                for (size_t i = 0; i < n; i += 256) {
+                    size_t m = std::min<size_t>(256, n - i);
+                    copy_units(chunk, p + i, m);
+                    h.update(chunk, m * sizeof(unit));
                 }
-            }
-            return result;
+            };
+            if (width == 1) narrow((unsigned char)0);
+            else narrow((char16_t)0);
+            return h.digest();
         }
 
-        inline stdx::string replace(char32_t oldChar, char32_t newChar) const {
-            stdx::string result = *this;
-            for (auto& c : result.data) {
-                if (c == oldChar) {
-                    c = newChar;
+        template<typename A, typename B>
+        inline bool equal_units(const A* a, const B* b, size_t n) {
+            if constexpr (std::is_same_v<A, B>) {
+                return n == 0 || memcmp(a, b, n * sizeof(A)) == 0;
+            }
+            else {
+                for (size_t i = 0; i < n; ++i) {
+                    if ((char32_t)a[i] != (char32_t)b[i]) return false;
                 }
+                return true;
             }
-            return result;
-		}
+        }
 
-		inline stdx::string replace(const stdx::string& oldStr, const stdx::string& newStr) const {
-            stdx::string result;
-            size_t pos = 0;
-            while (pos < data.size()) {
-                bool matched = true;
-                if (pos + oldStr.data.size() <= data.size()) {
-                    for (size_t i = 0; i < oldStr.data.size(); ++i) {
-                        if (data[pos + i] != oldStr.data[i]) {
-                            matched = false;
-                            break;
-                        }
-                    }
-                }
-                else {
-                    matched = false;
-                }
-                if (matched) {
-                    result.data.insert(result.data.end(), newStr.data.begin(), newStr.data.end());
-                    pos += oldStr.data.size();
-                }
-                else {
-                    result.data.push_back(data[pos]);
-                    pos++;
-                }
+        // -1, 0 or 1 as a[0, na) sorts before, with or after b[0, nb) by
+        // code point. Latin-1 bytes order like code points, so memcmp does;
+        // wider units are little-endian, so their first difference is found
+        // with the mismatch kernel and compared as code points.
+        template<typename A, typename B>
+        inline int compare_units(const A* a, size_t na, const B* b, size_t nb) {
+            size_t n = std::min(na, nb), i = 0;
+            if constexpr (std::is_same_v<A, B> && sizeof(A) == 1) {
+                int r = n ? memcmp(a, b, n) : 0;
+                if (r) return r < 0 ? -1 : 1;
+                i = n;
             }
-            return result;
+            else if constexpr (std::is_same_v<A, B>) {
+                i = scan::mismatch(a, b, n);
+            }
+            else {
+                while (i < n && (char32_t)a[i] == (char32_t)b[i]) ++i;
+            }
+            if (i < n) return (char32_t)a[i] < (char32_t)b[i] ? -1 : 1;
+            return na < nb ? -1 : na > nb ? 1 : 0;
         }
 
-        inline stdx::string replace(const std::string& oldStr, const std::string& newStr) const {
-            return replace(stdx::string(oldStr), stdx::string(newStr));
+        // Single-unit scans run on the SIMD kernels of stdxscan.h; a code
+        // point wider than the storage cannot occur in it.
+        template<typename Unit>
+        inline size_t find_unit(const Unit* p, size_t n, char32_t c, size_t from) {
+            return scan::find(p, n, c, from);
         }
 
-        inline stdx::string replace(const std::wstring& oldStr, const std::wstring& newStr) const {
-            return replace(stdx::string(oldStr), stdx::string(newStr));
+        template<typename Unit>
+        inline size_t rfind_unit(const Unit* p, size_t n, char32_t c) {
+            return scan::rfind(p, n, c);
         }
 
-        inline bool starts_with(const stdx::string& prefix) const {
-            if (prefix.data.size() > data.size()) return false;
-            for (size_t i = 0; i < prefix.data.size(); ++i) {
-                if (data[i] != prefix.data[i]) return false;
-            }
-            return true;
-		}
+        template<typename A, typename B>
+        inline size_t find_units(const A* hay, size_t n, const B* needle, size_t m, size_t from) {
+            return search::find(hay, n, needle, m, from);
+        }
 
-        inline bool ends_with(const stdx::string& suffix) const {
-            if (suffix.data.size() > data.size()) return false;
-            size_t offset = data.size() - suffix.data.size();
-            for (size_t i = 0; i < suffix.data.size(); ++i) {
-                if (data[offset + i] != suffix.data[i]) return false;
-            }
-            return true;
-		}
+        // [start, end) of p[0, n) with trim spaces dropped from the given side(s).
+        template<typename Unit>
+        inline size_t trim_start_index(const Unit* p, size_t n) {
+            size_t i = scan::find_not(p, n, scan::trim_spaces);
+            return i == npos ? n : i;
+        }
 
-        inline void trim_start() {
-            size_t start = 0;
-            while (start < data.size() && (data[start] == U' ' || data[start] == U'\t' || data[start] == U'\n' || data[start] == U'\r')) {
-                start++;
+        template<typename Unit>
+        inline size_t trim_end_index(const Unit* p, size_t n) {
+            size_t i = scan::rfind_not(p, n, scan::trim_spaces);
+            return i == npos ? 0 : i + 1;
+        }
+
+        // Random-access iterator over anything with a size_t operator[];
+        // it stores an index so it stays valid when the storage widens.
+        template<typename Owner, typename Ref>
+        class index_iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = char32_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Ref;
+
+            index_iterator() = default;
+            index_iterator(Owner* s, size_t index) : m_str(s), m_index(index) {}
+            template<typename O, typename R, typename = std::enable_if_t<std::is_convertible_v<O*, Owner*>>>
+            index_iterator(const index_iterator<O, R>& other) : m_str(other.owner()), m_index(other.index()) {}
+
+            inline Ref operator*() const { return (*m_str)[m_index]; }
+            inline Ref operator[](difference_type n) const { return (*m_str)[m_index + n]; }
+
+            inline index_iterator& operator++() { ++m_index; return *this; }
+            inline index_iterator operator++(int) { index_iterator t = *this; ++m_index; return t; }
+            inline index_iterator& operator--() { --m_index; return *this; }
+            inline index_iterator operator--(int) { index_iterator t = *this; --m_index; return t; }
+            inline index_iterator& operator+=(difference_type n) { m_index += n; return *this; }
+            inline index_iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+            inline index_iterator operator+(difference_type n) const { return index_iterator(m_str, m_index + n); }
+            inline index_iterator operator-(difference_type n) const { return index_iterator(m_str, m_index - n); }
+            inline friend index_iterator operator+(difference_type n, const index_iterator& it) { return it + n; }
+            inline difference_type operator-(const index_iterator& rhs) const { return (difference_type)m_index - (difference_type)rhs.m_index; }
+
+            inline bool operator==(const index_iterator& rhs) const { return m_index == rhs.m_index; }
+            inline bool operator!=(const index_iterator& rhs) const { return m_index != rhs.m_index; }
+            inline bool operator<(const index_iterator& rhs) const { return m_index < rhs.m_index; }
+            inline bool operator>(const index_iterator& rhs) const { return m_index > rhs.m_index; }
+            inline bool operator<=(const index_iterator& rhs) const { return m_index <= rhs.m_index; }
+            inline bool operator>=(const index_iterator& rhs) const { return m_index >= rhs.m_index; }
+
+            inline Owner* owner() const { return m_str; }
+            inline size_t index() const { return m_index; }
+
+        private:
+            Owner* m_str = nullptr;
+            size_t m_index = 0;
+        };
+
+#if !defined(STDX_FLOAT_TO_CHARS)
+        //============================
+        // Floating point without to_chars
+        //============================
+        // Stand-ins for the floating-point std::to_chars / std::from_chars
+        // overloads, built on printf and strtod and giving the same text:
+        // the shortest digits that read back when no precision is given,
+        // hex without "0x", and nothing from_chars would not accept (space,
+        // '+', a "0x" prefix). strtod reads the C locale's decimal point.
+        template<typename T>
+        inline int print_float(char* first, char* last, char conversion, int precision, T value) {
+            char format[] = { '%', '.', '*', 'L', conversion, 0 };
+            if constexpr (std::is_same_v<T, long double>) return snprintf(first, last - first, format, precision, value);
+            format[3] = conversion;
+            format[4] = 0;
+            return snprintf(first, last - first, format, precision, (double)value);
+        }
+
+        template<typename T>
+        inline T read_float(const char* s, char** end) {
+            if constexpr (std::is_same_v<T, float>) return strtof(s, end);
+            else if constexpr (std::is_same_v<T, double>) return strtod(s, end);
+            else return strtold(s, end);
+        }
+
+        // format {} is the overload without one: fixed or scientific,
+        // whichever is shorter (fixed on a tie). precision < 0: shortest.
+        template<typename T>
+        inline std::to_chars_result float_to_chars(char* first, char* last, T value, std::chars_format format, int precision) {
+            auto done = [&](int n) {
+                return n < 0 || n >= last - first ? std::to_chars_result{ last, std::errc::value_too_large } : std::to_chars_result{ first + n, std::errc() };
+            };
+            char conversion = format == std::chars_format::fixed ? 'f' : format == std::chars_format::scientific ? 'e' : format == std::chars_format::hex ? 'a' : 'g';
+            if (format == std::chars_format::hex) {
+                int n = print_float(first, last, 'a', precision, value);
+                char* digits = first + (*first == '-');
+                if (n > 0 && n < last - first && digits[0] == '0' && digits[1] == 'x') {
+                    memmove(digits, digits + 2, first + n - digits - 2);
+                    n -= 2;
+                }
+                return done(n);
             }
-            if (start > 0) {
-                data.erase(data.begin(), data.begin() + start);
+            if (precision >= 0 || !std::isfinite(value)) {
+                if (format == std::chars_format{}) conversion = 'g';
+                return done(print_float(first, last, conversion, precision < 0 ? 6 : precision, value));
             }
-		}
-
-        inline stdx::string trimmed_start() const {
-            stdx::string result = *this;
-            result.trim_start();
-            return result;
-		}
 
-        inline void trim_end() {
-            if (data.empty()) return;
-            size_t end = data.size() - 1;
-            while (end != (size_t)-1 && (data[end] == U' ' || data[end] == U'\t' || data[end] == U'\n' || data[end] == U'\r')) {
-                if (end == 0) { data.clear(); return; }
-                end--;
+            // the fewest significant digits that read back as value
+            char e[64];
+            int digits = 1;
+            for (;; ++digits) {
+                print_float(e, e + sizeof(e), 'e', digits - 1, value);
+                if (read_float<T>(e, nullptr) == value || digits >= std::numeric_limits<T>::max_digits10) break;
+            }
+            int exponent = atoi(strchr(e, 'e') + 1);
+            // general picks its style as %g does at the default precision
+            if (format == std::chars_format::general) format = exponent < -4 || exponent >= 6 ? std::chars_format::scientific : std::chars_format::fixed;
+            int e_size = (int)strlen(e);
+            bool negative = e[0] == '-';
+            if (format == std::chars_format{}) {
+                int fixed_size = negative + (exponent >= digits - 1 ? exponent + 1 : (exponent >= 0 ? exponent + 2 : 2) + (digits - 1 - exponent));
+                if (e_size < fixed_size) format = std::chars_format::scientific;
+            }
+            if (format == std::chars_format::scientific) {
+                if (e_size >= last - first) return done(-1);
+                memcpy(first, e, e_size);
+                return done(e_size);
             }
-            data.erase(data.begin() + end + 1, data.end());
+            // an integer prints in full, as the exact value it holds
+            return done(print_float(first, last, 'f', std::max(0, digits - 1 - exponent), value));
         }
 
-        inline stdx::string trimmed_end() const {
-            stdx::string result = *this;
-            result.trim_end();
-            return result;
+        template<typename T>
+        inline std::from_chars_result float_from_chars(const char* first, const char* last, T& value) {
+            const char* p = first + (first != last && *first == '-');
+            if (p == last || !((*p >= '0' && *p <= '9') || *p == '.' || *p == 'i' || *p == 'I' || *p == 'n' || *p == 'N')) return { first, std::errc::invalid_argument };
+            if (last - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+                // from_chars reads the "0" and stops at the 'x'
+                value = *first == '-' ? -(T)0 : (T)0;
+                return { p + 1, std::errc() };
+            }
+            // strtod needs a terminator
+            char local[64];
+            size_t n = (size_t)(last - first);
+            std::unique_ptr<char[]> heap(n >= sizeof(local) ? new char[n + 1] : nullptr);
+            char* buf = heap ? heap.get() : local;
+            memcpy(buf, first, n);
+            buf[n] = 0;
+            char* end;
+            errno = 0;
+            T v = read_float<T>(buf, &end);
+            if (end == buf) return { first, std::errc::invalid_argument };
+            const char* ptr = first + (end - buf);
+            // overflow, or underflow all the way to zero
+            if (errno == ERANGE && (v == 0 || std::isinf(v))) return { ptr, std::errc::result_out_of_range };
+            value = v;
+            return { ptr, std::errc() };
         }
+#endif
+    }
+
+    class string;
+    class tokenizer;
+    class atom;
+    class atom_table;
+    class glob;
+    class shared_string;
+
+    struct split_options {
+        bool keep_empty = false;         // yield empty fields ("a,,b" -> "a", "", "b")
+        size_t max_splits = (size_t)-1;  // after this many fields the rest is one field
+    };
 
-        inline void trim() {
-            trim_start();
-            trim_end();
-		}
+    //============================
+    // Non-owning view
+    //============================
+    // A window onto code-point storage, normally a stdx::string's. Nothing is
+    // copied, so a view must not outlive (or see a reallocation of) the
+    // string it came from. substr/split/trimmed on a view return views.
+    class string_view {
+    public:
+        using const_iterator = detail::index_iterator<const string_view, char32_t>;
+        using iterator = const_iterator;
 
-        inline stdx::string trimmed() const {
-            stdx::string result = *this;
-            result.trim();
-            return result;
-		}
+        static constexpr size_t npos = (size_t)-1;
 
-        inline size_t length() const {
-            return data.size();
-		}
+        string_view() = default;
+        string_view(const unsigned char* latin1, size_t n) : m_ptr(latin1), m_size(n), m_width(1) {}
+        string_view(const char16_t* ucs2, size_t n) : m_ptr((const unsigned char*)ucs2), m_size(n), m_width(2) {}
+        string_view(const char32_t* s, size_t n) : m_ptr((const unsigned char*)s), m_size(n), m_width(4) {}
 
-		inline size_t index_of(char32_t c) const {
-            for (size_t i = 0; i < data.size(); ++i) {
-                if (data[i] == c) return i;
-            }
-            return stdx::string::npos;
-        }
+        inline size_t size() const { return m_size; }
+        inline size_t length() const { return m_size; }
+        inline bool empty() const { return m_size == 0; }
+        inline size_t width() const { return m_width; }
 
-        inline size_t last_index_of(char32_t c) const {
-            for (size_t i = data.size(); i-- > 0;) {
-                if (data[i] == c) return i;
-            }
-            return stdx::string::npos;
-		}
+        inline char32_t operator[](size_t index) const {
+            return visit([&](const auto* p) { return (char32_t)p[index]; });
+        }
 
-        inline bool contains(char32_t c) const {
-            return index_of(c) != stdx::string::npos;
+        inline char32_t at(size_t index) const {
+            return (index < m_size) ? (*this)[index] : U'\0';
         }
 
-		inline bool contains(const stdx::string& str) const {
-            if (str.data.size() > data.size()) return false;
-            for (size_t i = 0; i <= data.size() - str.data.size(); ++i) {
-                bool matched = true;
-                for (size_t j = 0; j < str.data.size(); ++j) {
-                    if (data[i + j] != str.data[j]) {
-                        matched = false;
-                        break;
-                    }
-                }
-                if (matched) return true;
-            }
-            return false;
+        inline string_view substr(size_t pos, size_t len = npos) const {
+            if (pos >= m_size) return string_view(m_ptr, 0, m_width);
+            return string_view(m_ptr + pos * m_width, std::min(len, m_size - pos), m_width);
         }
 
-        inline bool contains(const std::string& str) const {
-            return contains(stdx::string(str));
-		}
+        inline string_view trimmed_start() const {
+            return substr(visit([&](const auto* p) { return detail::trim_start_index(p, m_size); }));
+        }
 
-        inline bool contains(const std::wstring& str) const {
-            return contains(stdx::string(str));
+        inline string_view trimmed_end() const {
+            return substr(0, visit([&](const auto* p) { return detail::trim_end_index(p, m_size); }));
         }
 
-		inline std::vector<stdx::string> split(char32_t delimiter) const {
-            if (data.empty()) return {};
-            std::vector<stdx::string> result;
-            size_t start = 0;
-            for (size_t i = 0; i < data.size(); ++i) {
-                if (data[i] == delimiter) {
-                    stdx::string part;
-                    part.data.assign(data.begin() + start, data.begin() + i);
-                    result.push_back(part);
-                    start = i + 1;
-                }
-            }
-            if (start < data.size()) {
-                stdx::string part;
-                part.data.assign(data.begin() + start, data.end());
-                result.push_back(part);
-            }
-            return result;
+        inline string_view trimmed() const {
+            return trimmed_end().trimmed_start();
         }
 
-		inline void pad_left(size_t totalWidth, char32_t paddingChar = U' ') {
-            if (data.size() >= totalWidth) return;
-            size_t padSize = totalWidth - data.size();
-            data.insert(data.begin(), padSize, paddingChar);
+        inline bool starts_with(string_view prefix) const {
+            return prefix.m_size <= m_size && substr(0, prefix.m_size) == prefix;
         }
 
-		inline stdx::string pad_left(size_t totalWidth, char32_t paddingChar = U' ') const {
-            stdx::string result = *this;
-            result.pad_left(totalWidth, paddingChar);
-            return result;
+        inline bool ends_with(string_view suffix) const {
+            return suffix.m_size <= m_size && substr(m_size - suffix.m_size) == suffix;
         }
 
-        inline void pad_right(size_t totalWidth, char32_t paddingChar = U' ') {
-            if (data.size() >= totalWidth) return;
-            size_t padSize = totalWidth - data.size();
-            data.insert(data.end(), padSize, paddingChar);
-		}
+        inline size_t index_of(char32_t c, size_t from = 0) const {
+            return visit([&](const auto* p) { return detail::find_unit(p, m_size, c, from); });
+        }
 
-        inline stdx::string pad_right(size_t totalWidth, char32_t paddingChar = U' ') const {
-            stdx::string result = *this;
-            result.pad_right(totalWidth, paddingChar);
-            return result;
+        inline size_t index_of(string_view str, size_t from = 0) const {
+            return find_from(str, from);
         }
 
-        inline void insert(size_t index, const stdx::string& str) {
-            if (index > data.size()) index = data.size();
-            data.insert(data.begin() + index, str.data.begin(), str.data.end());
-		}
+        // First position at or after from holding any code point in chars.
+        inline size_t index_of_any(string_view chars, size_t from = 0) const {
+            if (chars.m_size <= scan::small_set::capacity) {
+                scan::small_set set = {};
+                chars.visit([&](const auto* q) { for (size_t i = 0; i < chars.m_size; ++i) set.members[set.size++] = q[i]; });
+                return visit([&](const auto* p) { return scan::find_any(p, m_size, set, from); });
+            }
+            uint32_t latin1[8] = {};
+            bool wide = false;
+            chars.visit([&](const auto* q) {
+                for (size_t i = 0; i < chars.m_size; ++i) {
+                    char32_t c = q[i];
+                    if (c < 256) latin1[c >> 5] |= 1u << (c & 31);
+                    else wide = true;
+                }
+            });
+            return visit([&](const auto* p) {
+                for (size_t i = from; i < m_size; ++i) {
+                    char32_t c = p[i];
+                    if (c < 256 ? (latin1[c >> 5] >> (c & 31)) & 1 : wide && chars.index_of(c) != npos) return i;
+                }
+                return npos;
+            });
+        }
 
-        inline stdx::string insert(size_t index, const stdx::string& str) const {
-            stdx::string result = *this;
-            result.insert(index, str);
-            return result;
-		}
+        inline size_t last_index_of(char32_t c) const {
+            return visit([&](const auto* p) { return detail::rfind_unit(p, m_size, c); });
+        }
 
-		inline void remove(size_t index, size_t count) {
-            if (index >= data.size()) return;
-            size_t rcount = std::min(count, data.size() - index);
-            data.erase(data.begin() + index, data.begin() + index + rcount);
+        inline size_t last_index_of(string_view str) const {
+            return visit([&](const auto* a) {
+                return str.visit([&](const auto* b) { return search::rfind(a, m_size, b, str.m_size); });
+            });
         }
 
-        inline stdx::string remove(size_t index, size_t count) const {
-            stdx::string result = *this;
-            result.remove(index, count);
+        // Start of every non-overlapping occurrence of str, left to right.
+        inline std::vector<size_t> find_all(string_view str) const {
+            std::vector<size_t> result;
+            visit([&](const auto* a) {
+                str.visit([&](const auto* b) {
+                    search::find_all(a, m_size, b, str.m_size, [&](size_t pos) { result.push_back(pos); });
+                });
+            });
             return result;
-		}
+        }
 
-        inline char32_t at(size_t index) const {
-            return (index < data.size()) ? data[index] : U'\0';
+        // First match of any of the matcher's patterns at or after from; the
+        // longest one when several start at the same place.
+        inline search::match find_any(const search::matcher& patterns, size_t from = 0) const {
+            return visit([&](const auto* p) { return patterns.find(p, m_size, from); });
         }
 
-        //============================
-		// Operator overloads
-        //============================
-        inline stdx::string& operator+=(const std::string& rhs) {
-            auto u = utf8_to_utf32(rhs);
-            data.insert(data.end(), u.begin(), u.end());
-            return *this;
+        inline bool contains(char32_t c) const {
+            return index_of(c) != npos;
         }
 
-        inline stdx::string& operator+=(const std::wstring& rhs) {
-#ifdef _WIN32
-            auto u16 = std::u16string(rhs.begin(), rhs.end());
-            auto u32 = utf16_to_utf32(u16);
-            data.insert(data.end(), u32.begin(), u32.end());
-#else
-            data.insert(data.end(), rhs.begin(), rhs.end());
-#endif
-            return *this;
+        // Occurrences of c.
+        inline size_t count(char32_t c) const {
+            return visit([&](const auto* p) { return scan::count(p, m_size, c); });
         }
 
-        inline stdx::string operator+(const std::string& rhs) const {
-            stdx::string out = *this;
-            out += rhs;
-            return out;
+        inline bool contains(string_view str) const {
+            return find_from(str, 0) != npos;
         }
 
-        inline stdx::string operator+(const std::wstring& rhs) const {
-            stdx::string out = *this;
-            out += rhs;
-            return out;
+        inline std::vector<string_view> split(char32_t delimiter) const {
+            std::vector<string_view> result;
+            split(delimiter, result);
+            return result;
         }
 
-        inline stdx::string operator+(const stdx::string& rhs) const {
-            stdx::string out = *this;
-            out.data.insert(out.data.end(), rhs.data.begin(), rhs.data.end());
-            return out;
-		}
+        // Same as split(delimiter), but fills out so a caller can reuse
+        // its capacity across lines.
+        inline void split(char32_t delimiter, std::vector<string_view>& out) const {
+            out.clear();
+            out.reserve(count(delimiter) + 1);
+            visit([&](const auto* p) {
+                size_t start = 0, hit;
+                while ((hit = detail::find_unit(p, m_size, delimiter, start)) != npos) {
+                    out.push_back(substr(start, hit - start));
+                    start = hit + 1;
+                }
+                if (start < m_size) out.push_back(substr(start));
+            });
+        }
 
-        inline stdx::string operator+=(const stdx::string& rhs) {
-            data.insert(data.end(), rhs.data.begin(), rhs.data.end());
-            return *this;
-		}
+        // Lazy, allocation-free splitting; see stdx::tokenizer.
+        inline tokenizer tokenize(char32_t delimiter, split_options options = {}) const;
+        inline tokenizer tokenize(string_view separator, split_options options = {}) const;
+        inline tokenizer tokenize_any(string_view delimiters, split_options options = {}) const;
 
-        inline bool operator==(const stdx::string& rhs) const {
-            return data == rhs.data;
-		}
+        inline stdx::string to_string() const;
 
-        inline bool operator!=(const stdx::string& rhs) const {
-            return data != rhs.data;
+        // Parses the whole view as std::from_chars does (floating point goes
+        // through strtod without it): no leading whitespace or '+', nothing
+        // left over. try_parse gives nullopt when the text is not such a
+        // number or does not fit T; parse throws std::invalid_argument /
+        // std::out_of_range like std::stoi.
+        template<typename T>
+        inline std::optional<T> try_parse() const {
+            T value{};
+            if (from_chars(value) != std::errc()) return std::nullopt;
+            return value;
         }
 
-        inline bool operator==(const std::string& rhs) const {
-            auto u = utf8_to_utf32(rhs);
-            return data.size() == u.size() && std::equal(data.begin(), data.end(), u.begin());
+        template<typename T>
+        inline std::optional<T> try_parse(int base) const {
+            static_assert(std::is_integral_v<T>, "a base only applies to integers");
+            T value{};
+            if (from_chars(value, base) != std::errc()) return std::nullopt;
+            return value;
         }
 
-        inline bool operator!=(const std::string& rhs) const {
-            return !(*this == rhs);
+        template<typename T>
+        inline T parse() const {
+            T value{};
+            throw_parse_error(from_chars(value));
+            return value;
         }
 
-        inline bool operator==(const std::wstring& rhs) const {
-            auto u = from_wstring(rhs);
-            return data.size() == u.size() && std::equal(data.begin(), data.end(), u.begin());
+        template<typename T>
+        inline T parse(int base) const {
+            static_assert(std::is_integral_v<T>, "a base only applies to integers");
+            T value{};
+            throw_parse_error(from_chars(value, base));
+            return value;
         }
 
-        inline bool operator!=(const std::wstring& rhs) const {
-            return !(*this == rhs);
+        inline bool operator==(string_view rhs) const {
+            if (m_size != rhs.m_size) return false;
+            return visit([&](const auto* a) {
+                return rhs.visit([&](const auto* b) { return detail::equal_units(a, b, m_size); });
+            });
         }
 
-        inline char32_t& operator[](size_t index) {
-            return data[index];
+        // Caseless comparison by simple case folding, folded as it goes.
+        inline bool equals_ignore_case(string_view other) const {
+            return m_size == other.m_size && compare_ignore_case(other) == 0;
         }
 
-        inline const char32_t& operator[](size_t index) const {
-            return data[index];
+        inline int compare_ignore_case(string_view other) const {
+            return visit([&](const auto* a) {
+                return other.visit([&](const auto* b) {
+                    size_t n = std::min(m_size, other.m_size), i = 0;
+                    if constexpr (sizeof(*a) == 1 && sizeof(*b) == 1) i = unicode::equal_ascii_folded(a, b, n);
+                    for (; i < n; ++i) {
+                        if (a[i] == b[i]) continue;
+                        char32_t x = unicode::fold(a[i]), y = unicode::fold(b[i]);
+                        if (x != y) return x < y ? -1 : 1;
+                    }
+                    return m_size < other.m_size ? -1 : m_size > other.m_size ? 1 : 0;
+                });
+            });
         }
 
-        inline auto begin() { return data.begin(); }
-        inline auto end() { return data.end(); }
-        inline auto begin() const { return data.begin(); }
-        inline auto end() const { return data.end(); }
-        inline auto cbegin() const { return data.cbegin(); }
-        inline auto cend() const { return data.cend(); }
-
-        std::vector<char32_t> data;
-    private:
-
-        mutable std::string  buf8;
-        mutable std::wstring buf16;
-        mutable std::u32string buf32;
+        inline bool operator!=(string_view rhs) const {
+            return !(*this == rhs);
+        }
 
-        const char32_t* select_cstr(utf32_t*) const
-        {
-            buf32.assign(data.begin(), data.end());
-            buf32.push_back(U'\0');
-            return buf32.c_str();
+        // Ordinal order by code point value (not locale collation): <0, 0
+        // or >0. A prefix sorts before the longer text.
+        inline int compare(string_view other) const {
+            return visit([&](const auto* a) {
+                return other.visit([&](const auto* b) { return detail::compare_units(a, m_size, b, other.m_size); });
+            });
         }
 
-        const char* select_cstr(utf8_t*) const
-        {
-            // convert UTF-32 vector to string
-            buf8 = utf32_to_utf8(std::u32string(data.begin(), data.end()));
-            return buf8.c_str();
+        inline bool operator<(string_view rhs) const { return compare(rhs) < 0; }
+        inline bool operator<=(string_view rhs) const { return compare(rhs) <= 0; }
+        inline bool operator>(string_view rhs) const { return compare(rhs) > 0; }
+        inline bool operator>=(string_view rhs) const { return compare(rhs) >= 0; }
+#if defined(STDX_STRING_THREE_WAY)
+        inline std::strong_ordering operator<=>(string_view rhs) const { return compare(rhs) <=> 0; }
+#endif
+
+        // Same value as stdx::string::hash() for equal contents.
+        inline size_t hash() const {
+            return (size_t)visit([&](const auto* p) { return detail::hash_code_points(p, m_size); });
         }
 
-        const wchar_t* select_cstr(utf16_t*) const
-        {
-            buf16 = toWstr();
-            return buf16.c_str();
+        // Compares against UTF-8 or wide (UTF-16 on Windows, else UTF-32) text
+        // decoded as it goes, without allocating; stops at the first difference.
+        inline bool equals(const char* utf8, size_t n) const {
+            // n bytes hold at most n code points, each of ours needs 1-4 bytes
+            if (n < m_size || n > m_size * (m_width == 1 ? 2 : 4)) return false;
+            return visit([&](const auto* p) { return utf::compare_utf8(p, m_size, utf8, n) == 0; });
         }
 
-        // utf8 -> utf32
-        void fromUtf8(const std::string& s) {
+        inline bool equals(const wchar_t* w, size_t n) const {
 #ifdef _WIN32
-            int wlen = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, 0, 0);
-            if (wlen <= 0) { data.clear(); return; }
-            std::wstring w(wlen, 0);
-            MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &w[0], wlen);
-            fromWstr(w);
+            if (n < m_size || n > m_size * 2) return false;
+            return visit([&](const auto* p) { return utf::compare_utf16(p, m_size, w, n) == 0; });
 #else
-            std::u32string u = utf8_to_utf32(s);
-            data.assign(u.begin(), u.end());
+            return n == m_size && visit([&](const auto* p) { return detail::equal_units(p, w, n); });
 #endif
         }
 
-        // utf16 or utf32 platform dependent
-        void fromWstr(const std::wstring& w) {
-#ifdef _WIN32
-            data.clear();
-            data.reserve(w.size());
-            for (size_t i = 0; i < w.size(); ++i) {
-                wchar_t c = w[i];
-
-                if (c == 0) break; // STOP at null terminator
-
-                if (c >= 0xD800 && c <= 0xDBFF && i + 1 < w.size()) {
-                    wchar_t c2 = w[i + 1];
-                    if (c2 >= 0xDC00 && c2 <= 0xDFFF) {
-                        char32_t cp = 0x10000 + (((c - 0xD800) << 10) | (c2 - 0xDC00));
-                        data.push_back(cp);
-                        ++i;
-                        continue;
-                    }
-                }
+        inline bool operator==(const char* rhs) const { return equals(rhs, strlen(rhs)); }
+        inline bool operator!=(const char* rhs) const { return !(*this == rhs); }
+        inline bool operator==(const wchar_t* rhs) const { return equals(rhs, wcslen(rhs)); }
+        inline bool operator!=(const wchar_t* rhs) const { return !(*this == rhs); }
+        inline bool operator==(const std::string& rhs) const { return equals(rhs.data(), rhs.size()); }
+        inline bool operator!=(const std::string& rhs) const { return !(*this == rhs); }
+        inline bool operator==(const std::wstring& rhs) const { return equals(rhs.data(), rhs.size()); }
+        inline bool operator!=(const std::wstring& rhs) const { return !(*this == rhs); }
+
+        // A UTF-8 copy of the text.
+        explicit operator std::string() const {
+            return visit([&](const auto* p) {
+                std::string s(utf::utf8_length_of(p, m_size), '\0');
+                utf::encode_utf8(p, m_size, &s[0]);
+                return s;
+            });
+        }
 
-                data.push_back((char32_t)c);
-            }
-#else
-            data.assign(w.begin(), w.end());
-#endif
+        inline const_iterator begin() const { return const_iterator(this, 0); }
+        inline const_iterator end() const { return const_iterator(this, m_size); }
+        inline const_iterator cbegin() const { return const_iterator(this, 0); }
+        inline const_iterator cend() const { return const_iterator(this, m_size); }
+
+    private:
+        friend class string;
+        friend class tokenizer;
+        friend class atom;
+        friend class atom_table;
+        friend class glob;
+        friend class shared_string;
+
+        string_view(const unsigned char* p, size_t n, unsigned width)
+            : m_ptr(p), m_size(n), m_width((unsigned char)width) {}
+
+        const unsigned char* m_ptr = nullptr;
+        size_t m_size = 0;
+        unsigned char m_width = 1;
+
+        template<typename F>
+        inline auto visit(F&& f) const -> decltype(f((const unsigned char*)nullptr)) {
+            return detail::visit_units(m_ptr, m_width, std::forward<F>(f));
         }
 
-        // utf32 -> utf8
-        std::string toUtf8() const {
-#ifdef _WIN32
-            std::wstring w = toWstr();
-            int len = WideCharToMultiByte(CP_UTF8, 0, w.c_str(), -1, 0, 0, 0, 0);
-            std::string s(len, 0);
-            WideCharToMultiByte(CP_UTF8, 0, w.c_str(), -1, &s[0], len, 0, 0);
-            return s;
-#else
-            std::u32string u(data.begin(), data.end());
-            return utf32_to_utf8(u);
-#endif
+        // Narrowest width that holds the viewed code points.
+        inline unsigned needed_width() const {
+            return m_width == 1 ? 1 : detail::width_for(visit([&](const auto* p) { return detail::code_point_bits(p, m_size); }));
         }
 
-        // utf32 -> wstring
-        std::wstring toWstr() const {
-#ifdef _WIN32
-            std::wstring w;
-            w.reserve(data.size());
-            for (char32_t cp : data) {
-                if (cp > 0xFFFF) {
-                    cp -= 0x10000;
-                    wchar_t high = 0xD800 + ((cp >> 10) & 0x3FF);
-                    wchar_t low = 0xDC00 + (cp & 0x3FF);
-                    w.push_back(high);
-                    w.push_back(low);
-                }
-                else {
-                    w.push_back((wchar_t)cp);
-                }
-            }
-            w.push_back(0);
-            return w;
-#else
-            return std::wstring(data.begin(), data.end()); // direct on Linux
-#endif
+        inline size_t find_from(string_view needle, size_t from) const {
+            return visit([&](const auto* a) {
+                return needle.visit([&](const auto* b) { return detail::find_units(a, m_size, b, needle.m_size, from); });
+            });
         }
 
-        static std::u32string from_wstring(const std::wstring& w)
-        {
-#ifdef _WIN32
-            return utf16_to_utf32(std::u16string(w.begin(), w.end()));
+        // Latin-1 storage is handed to from_chars as is; wider storage is
+        // narrowed first, and cannot be a number if any unit is not ASCII.
+        template<typename T, typename... Args>
+        inline std::errc from_chars(T& value, Args... args) const {
+            static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "parse supports integer and floating point types");
+            auto run = [&](const char* first, const char* last) {
+#if defined(STDX_FLOAT_TO_CHARS)
+                std::from_chars_result r = std::from_chars(first, last, value, args...);
 #else
-            return std::u32string(w.begin(), w.end());
+                std::from_chars_result r;
+                if constexpr (std::is_floating_point_v<T>) r = detail::float_from_chars(first, last, value);
+                else r = std::from_chars(first, last, value, args...);
 #endif
+                return r.ec == std::errc() && r.ptr != last ? std::errc::invalid_argument : r.ec;
+            };
+            if (m_width == 1) return run((const char*)m_ptr, (const char*)m_ptr + m_size);
+            if (visit([&](const auto* p) { return detail::code_point_bits(p, m_size); }) > 0x7F) return std::errc::invalid_argument;
+            char local[64] = {};
+            std::unique_ptr<char[]> heap(m_size > sizeof(local) ? new char[m_size] : nullptr);
+            char* buf = heap ? heap.get() : local;
+            visit([&](const auto* p) { detail::copy_units((unsigned char*)buf, p, m_size); });
+            return run(buf, buf + m_size);
         }
 
-        static std::wstring to_wstring(const std::u32string& u)
-        {
-#ifdef _WIN32
-            auto u16 = utf32_to_utf16(u);
-            return std::wstring(u16.begin(), u16.end());
-#else
-            return std::wstring(u.begin(), u.end());
-#endif
+        static void throw_parse_error(std::errc ec) {
+            if (ec == std::errc::result_out_of_range) throw std::out_of_range("stdx::string::parse: value out of range");
+            if (ec != std::errc()) throw std::invalid_argument("stdx::string::parse: not a number");
         }
+    };
 
-        static std::u32string utf8_to_utf32(const std::string& s)
-        {
-            std::u32string out;
-            out.reserve(s.size());
+    class string;
 
-            size_t i = 0;
-            while (i < s.size())
-            {
-                uint32_t c = (unsigned char)s[i];
-                size_t extra = 0;
-
-                if (c < 0x80) { extra = 0; }
-                else if ((c >> 5) == 0x6) { extra = 1; c &= 0x1F; }
-                else if ((c >> 4) == 0xE) { extra = 2; c &= 0x0F; }
-                else if ((c >> 3) == 0x1E) { extra = 3; c &= 0x07; }
-                else { out.push_back(0xFFFD); i++; continue; }
-
-                if (i + extra >= s.size()) { out.push_back(0xFFFD); break; }
-
-                for (size_t j = 1; j <= extra; j++)
-                {
-                    unsigned char cc = s[i + j];
-                    if ((cc >> 6) != 0x2) { out.push_back(0xFFFD); goto next; }
-                    c = (c << 6) | (cc & 0x3F);
-                }
+    namespace detail {
+        template<typename T>
+        constexpr bool is_code_unit = std::is_same_v<T, char> || std::is_same_v<T, wchar_t> || std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+
+        // What concat() and string_builder take as text: strings and views
+        // of any supported encoding, and single characters. Other integers
+        // are not code points and are rejected instead of converted.
+        template<typename T, typename D = std::decay_t<T>>
+        constexpr bool is_text_part = is_code_unit<D> ||
+            std::is_same_v<D, const char*> || std::is_same_v<D, char*> ||
+            std::is_same_v<D, const wchar_t*> || std::is_same_v<D, wchar_t*> ||
+            std::is_same_v<D, std::string> || std::is_same_v<D, std::wstring> || std::is_same_v<D, stdx::string> ||
+            (std::is_class_v<D> && std::is_convertible_v<const T&, string_view>);
+    }
+
+    //============================
+    // Utility methods
+    //============================
+    class string {
+    public:
+        // Writable element handle: storage may widen when a code point is
+        // assigned, so a plain char32_t& cannot be handed out.
+        class reference {
+        public:
+            reference(string* s, size_t index) : m_str(s), m_index(index) {}
+
+            inline operator char32_t() const { return m_str->get(m_index); }
+            inline reference& operator=(char32_t c) { m_str->set(m_index, c); return *this; }
+            inline reference& operator=(const reference& other) { return *this = (char32_t)other; }
+
+        private:
+            string* m_str;
+            size_t m_index;
+        };
+
+        template<typename Owner, typename Ref>
+        using basic_iterator = detail::index_iterator<Owner, Ref>;
+
+        using iterator = basic_iterator<string, reference>;
+        using const_iterator = basic_iterator<const string, char32_t>;
+
+        // Heap storage and the c_str() buffers come from a memory resource.
+        // Strings built without an allocator use plain new/delete. Like
+        // std::pmr::string, a copy does not inherit the source's resource;
+        // a move takes it along. Transforming members (substr, split,
+        // replace, trimmed, ...) build their results in this string's
+        // resource, so a std::pmr::monotonic_buffer_resource can back a
+        // whole batch of work and be released in one go.
+        using allocator_type = std::pmr::polymorphic_allocator<unsigned char>;
 
-                out.push_back(c);
-                i += extra + 1;
-                continue;
+        string() = default;
+        explicit string(const allocator_type& alloc) : m_resource(resource_of(alloc)) {}
+
+        string(const char* s) { fromUtf8(s, strlen(s)); }
+        string(const std::string& s) { fromUtf8(s.data(), s.size()); }
+        string(const wchar_t* s) { fromWstr(s, wcslen(s)); }
+        string(const std::wstring& s) { fromWstr(s.data(), s.size()); }
+        string(const std::u32string& s) { assign_code_points(s.data(), s.size()); }
+        explicit string(string_view v) { append(v); }
+
+        string(const char* s, const allocator_type& alloc) : m_resource(resource_of(alloc)) { fromUtf8(s, strlen(s)); }
+        string(const std::string& s, const allocator_type& alloc) : m_resource(resource_of(alloc)) { fromUtf8(s.data(), s.size()); }
+        string(const wchar_t* s, const allocator_type& alloc) : m_resource(resource_of(alloc)) { fromWstr(s, wcslen(s)); }
+        string(const std::wstring& s, const allocator_type& alloc) : m_resource(resource_of(alloc)) { fromWstr(s.data(), s.size()); }
+        string(const std::u32string& s, const allocator_type& alloc) : m_resource(resource_of(alloc)) { assign_code_points(s.data(), s.size()); }
+        string(string_view v, const allocator_type& alloc) : m_resource(resource_of(alloc)) { append(v); }
+
+        string(const string& other) : string(other, default_allocator()) {}
+
+        string(const string& other, const allocator_type& alloc) : m_resource(resource_of(alloc)) {
+            if (other.empty()) return;
+            make_room(other.m_size, other.m_width);
+            other.visit([&](const auto* src) { copy_into(0, src, other.m_size); });
+            set_length(other.m_size);
+        }
 
-            next:
-                i++;
-            }
+        string(string&& other) noexcept : m_resource(other.m_resource) {
+            take(other);
+        }
 
-            return out;
+        // Takes other's buffer when it comes from alloc's resource, else copies.
+        string(string&& other, const allocator_type& alloc) : m_resource(resource_of(alloc)) {
+            if (m_resource == other.m_resource) take(other);
+            else *this = other;
         }
 
-        static std::string utf32_to_utf8(const std::u32string& s)
-        {
-            std::string out;
-            out.reserve(s.size());
-
-            for (uint32_t cp : s)
-            {
-                if (cp <= 0x7F)
-                {
-                    out.push_back((char)cp);
-                }
-                else if (cp <= 0x7FF)
-                {
-                    out.push_back((char)(0xC0 | (cp >> 6)));
-                    out.push_back((char)(0x80 | (cp & 0x3F)));
-                }
-                else if (cp <= 0xFFFF)
-                {
-                    out.push_back((char)(0xE0 | (cp >> 12)));
-                    out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
-                    out.push_back((char)(0x80 | (cp & 0x3F)));
-                }
-                else
-                {
-                    out.push_back((char)(0xF0 | (cp >> 18)));
-                    out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
-                    out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
-                    out.push_back((char)(0x80 | (cp & 0x3F)));
-                }
+        string& operator=(const string& other) {
+            if (this != &other) {
+                m_size = 0;
+                make_room(other.m_size, other.m_width);
+                other.visit([&](const auto* src) { copy_into(0, src, other.m_size); });
+                set_length(other.m_size);
             }
-
-            return out;
+            return *this;
         }
 
-        static std::u32string utf16_to_utf32(const std::u16string& in)
+        // Keeps this string's resource: steals other's buffer only when it
+        // comes from the same one.
+        string& operator=(string&& other) {
+            if (this != &other) {
+                if (m_resource != other.m_resource) return *this = other;
+                release();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~string() { release(); }
+
+        inline allocator_type get_allocator() const {
+            return allocator_type(m_resource ? m_resource : std::pmr::new_delete_resource());
+        }
+
+        operator std::string() const { return toUtf8(); }
+        operator std::wstring() const { return toWstr(); }
+        operator string_view() const { return view(); }
+
+        // Non-owning view of [pos, pos + len); valid until this string is
+        // modified or destroyed.
+        inline string_view view(size_t pos = 0, size_t len = npos) const {
+            return string_view(m_ptr, m_size, m_width).substr(pos, len);
+        }
+
+        inline size_t size() const { return m_size; }
+        inline bool empty() const { return m_size == 0; }
+        inline size_t capacity() const { return is_local() ? local_bytes / m_width - 1 : heap_cap(); }
+
+        // Bytes per stored code point: 1 (Latin-1), 2 (UCS-2) or 4 (UTF-32).
+        inline size_t width() const { return m_width; }
+
+        inline void reserve(size_t n) { make_room(n, m_width); }
+
+        // Drops spare capacity and narrows storage to the smallest width that
+        // still fits, e.g. after the only wide code point was removed.
+        inline void shrink_to_fit() {
+            unsigned w = m_width == 1 ? 1 : detail::width_for(bits());
+            if (w == m_width && capacity() == m_size) return;
+            reallocate(m_size, w);
+        }
+
+        struct utf8_t {};
+        struct utf16_t {};
+        struct utf32_t {};
+
+        // Terminated text in the given encoding. It may point into this
+        // string's own storage, so any modification (or destruction)
+        // invalidates it.
+        template<typename Encoding>
+        auto c_str() const
+        {
+            static_assert(std::is_same_v<Encoding, utf8_t> ||
+                          std::is_same_v<Encoding, utf16_t> ||
+                          std::is_same_v<Encoding, utf32_t>,
+                "Unsupported encoding type");
+
+            return select_cstr(static_cast<Encoding*>(nullptr));
+        }
+
+        inline void clear() { set_length(0); }
+        inline void push_back(char32_t c) {
+            make_room(m_size + 1, detail::width_for(c));
+            put(m_size, c);
+            set_length(m_size + 1);
+        }
+        inline void push_back(char c) {
+            if ((unsigned char)c < 0x80) {
+                push_back((char32_t)c);
+            }
+        }
+        inline void push_back(wchar_t c) {
+#ifdef _WIN32
+            // cannot append a lone high surrogate
+            if (c >= 0xD800 && c <= 0xDBFF) return; // invalid alone
+            if (c >= 0xDC00 && c <= 0xDFFF) return; // invalid alone
+            push_back((char32_t)c);
+#else
+            push_back((char32_t)c);
+#endif
+        }
+
+        inline reference back() { return reference(this, m_size - 1); }
+        inline char32_t back() const { return get(m_size - 1); }
+
+        inline void append(const stdx::string& other) {
+            append(other.view());
+        }
+        inline void append(string_view other) {
+            if (other.empty()) return;
+            if (views_self(other)) {
+                append(stdx::string(other)); // a view into ourselves would dangle on growth
+                return;
+            }
+            make_room(m_size + other.m_size, other.m_width > m_width ? other.needed_width() : m_width);
+            other.visit([&](const auto* p) { copy_into(m_size, p, other.m_size); });
+            set_length(m_size + other.m_size);
+        }
+        inline void append(const std::string& other) {
+            appendUtf8(other.data(), other.size());
+        }
+        inline void append(const std::wstring& other)
         {
-            std::u32string out;
-            out.reserve(in.size());
-
-            for (size_t i = 0; i < in.size(); ++i)
-            {
-                char16_t c = in[i];
-
-                // high surrogate?
-                if (c >= 0xD800 && c <= 0xDBFF && i + 1 < in.size())
-                {
-                    char16_t c2 = in[i + 1];
-                    if (c2 >= 0xDC00 && c2 <= 0xDFFF)
-                    {
-                        char32_t cp = 0x10000 + (((c - 0xD800) << 10) | (c2 - 0xDC00));
-                        out.push_back(cp);
-                        ++i;
-                        continue;
+            appendWstr(other.data(), other.size());
+        }
+
+        inline void resize(size_t newSize) {
+            if (newSize > m_size) {
+                make_room(newSize, m_width);
+                visit([&](auto* p) { detail::fill_units(p + m_size, U'\0', newSize - m_size); });
+            }
+            set_length(newSize);
+        }
+
+        inline stdx::string substr(size_t pos, size_t len) const& {
+            stdx::string result(get_allocator());
+            if (pos < m_size) {
+                size_t rlen = std::min(len, m_size - pos);
+                visit([&](const auto* p) { result.assign_code_points(p + pos, rlen); });
+            }
+            return result;
+        }
+
+        // The && overloads below transform the expiring string in place and
+        // hand its buffer on, so std::move(s).to_upper().trimmed() never copies.
+        inline stdx::string substr(size_t pos, size_t len) && {
+            if (pos >= m_size) pos = m_size;
+            size_t rlen = std::min(len, m_size - pos);
+            if (pos > 0) visit([&](auto* p) { detail::copy_units(p, p + pos, rlen); });
+            set_length(rlen);
+            return std::move(*this);
+        }
+
+        // Unicode simple case mapping; the copies are written straight from
+        // this string, the make_* versions work in place.
+        inline stdx::string to_upper() const& { return mapped_case<unicode::case_kind::upper>(); }
+        inline stdx::string to_lower() const& { return mapped_case<unicode::case_kind::lower>(); }
+        inline stdx::string to_folded() const& { return mapped_case<unicode::case_kind::fold>(); }
+        inline stdx::string to_upper() && { make_upper(); return std::move(*this); }
+        inline stdx::string to_lower() && { make_lower(); return std::move(*this); }
+        inline stdx::string to_folded() && { make_folded(); return std::move(*this); }
+
+        inline void make_upper() { map_case_in_place<unicode::case_kind::upper>(); }
+        inline void make_lower() { map_case_in_place<unicode::case_kind::lower>(); }
+        inline void make_folded() { map_case_in_place<unicode::case_kind::fold>(); }
+
+        inline bool equals_ignore_case(const stdx::string& other) const { return view().equals_ignore_case(other.view()); }
+        inline bool equals_ignore_case(string_view other) const { return view().equals_ignore_case(other); }
+        inline int compare_ignore_case(const stdx::string& other) const { return view().compare_ignore_case(other.view()); }
+        inline int compare_ignore_case(string_view other) const { return view().compare_ignore_case(other); }
+
+        inline stdx::string replace(char32_t oldChar, char32_t newChar) const& {
+            return stdx::string(*this, get_allocator()).replace(oldChar, newChar);
+        }
+
+        inline stdx::string replace(char32_t oldChar, char32_t newChar) && {
+            size_t first = index_of(oldChar);
+            if (first == npos || oldChar == newChar) return std::move(*this);
+            make_room(m_size, detail::width_for(newChar));
+            visit([&](auto* p) { scan::replace(p + first, m_size - first, oldChar, newChar); });
+            return std::move(*this);
+        }
+
+        inline stdx::string replace(const stdx::string& oldStr, const stdx::string& newStr) const& {
+            return replace(oldStr.view(), newStr.view());
+        }
+
+        inline stdx::string replace(const stdx::string& oldStr, const stdx::string& newStr) && {
+            return std::move(*this).replace(oldStr.view(), newStr.view());
+        }
+
+        // Replacements no longer than the text they replace are compacted
+        // into the expiring buffer front to back; longer ones need a new one.
+        inline stdx::string replace(string_view oldStr, string_view newStr) && {
+            if (oldStr.empty() || newStr.m_size > oldStr.m_size || views_self(newStr) || newStr.needed_width() > m_width) {
+                return static_cast<const stdx::string&>(*this).replace(oldStr, newStr);
+            }
+            std::vector<size_t> hits = find_all(oldStr);
+            if (hits.empty()) return std::move(*this);
+            size_t dst = hits[0], pos = hits[0];
+            visit([&](auto* p) {
+                newStr.visit([&](const auto* r) {
+                    for (size_t hit : hits) {
+                        detail::copy_units(p + dst, p + pos, hit - pos);
+                        dst += hit - pos;
+                        detail::copy_units(p + dst, r, newStr.m_size);
+                        dst += newStr.m_size;
+                        pos = hit + oldStr.m_size;
                     }
+                    detail::copy_units(p + dst, p + pos, m_size - pos);
+                });
+            });
+            set_length(dst + m_size - pos);
+            return std::move(*this);
+        }
+
+        inline stdx::string replace(string_view oldStr, string_view newStr) const& {
+            if (oldStr.empty()) return stdx::string(*this, get_allocator());
+            std::vector<size_t> hits = find_all(oldStr);
+            if (hits.empty()) return stdx::string(*this, get_allocator());
+            // one allocation, sized from the match count
+            stdx::string result(get_allocator());
+            result.make_room(m_size - hits.size() * oldStr.m_size + hits.size() * newStr.m_size,
+                std::max(needed_width(), newStr.needed_width()));
+            size_t pos = 0;
+            for (size_t hit : hits) {
+                result.append_range(*this, pos, hit - pos);
+                result.append(newStr);
+                pos = hit + oldStr.m_size;
+            }
+            result.append_range(*this, pos, m_size - pos);
+            return result;
+        }
+
+        // Single-pass multi-pattern replace: every non-overlapping match of
+        // pattern i becomes replacements[i], matches taken leftmost-longest
+        // as find_any does. Unlike chained replace() calls, replaced text is
+        // never rescanned.
+        inline stdx::string replace_all(const search::matcher& patterns, const std::vector<stdx::string>& replacements) const {
+            if (replacements.size() < patterns.size())
+                throw std::invalid_argument("stdx::string::replace_all: missing replacements");
+            std::vector<search::match> hits;
+            size_t total = m_size;
+            unsigned width = needed_width();
+            visit([&](const auto* p) {
+                patterns.find_all(p, m_size, [&](const search::match& m) {
+                    const stdx::string& r = replacements[m.pattern];
+                    total = total - m.length + r.m_size;
+                    width = std::max(width, r.needed_width());
+                    hits.push_back(m);
+                });
+            });
+            if (hits.empty()) return stdx::string(*this, get_allocator());
+            stdx::string result(get_allocator());
+            result.make_room(total, width);
+            result.visit([&](auto* dst) {
+                visit([&](const auto* src) {
+                    size_t pos = 0;
+                    for (const search::match& m : hits) {
+                        detail::copy_units(dst, src + pos, m.pos - pos);
+                        dst += m.pos - pos;
+                        const stdx::string& r = replacements[m.pattern];
+                        r.visit([&](const auto* rp) { detail::copy_units(dst, rp, r.m_size); });
+                        dst += r.m_size;
+                        pos = m.pos + m.length;
+                    }
+                    detail::copy_units(dst, src + pos, m_size - pos);
+                });
+            });
+            result.set_length(total);
+            return result;
+        }
+
+        inline stdx::string replace(const std::string& oldStr, const std::string& newStr) const& {
+            return with_view(oldStr.data(), oldStr.size(), [&](string_view o) {
+                return with_view(newStr.data(), newStr.size(), [&](string_view n) { return replace(o, n); });
+            });
+        }
+
+        inline stdx::string replace(const std::string& oldStr, const std::string& newStr) && {
+            return with_view(oldStr.data(), oldStr.size(), [&](string_view o) {
+                return with_view(newStr.data(), newStr.size(), [&](string_view n) { return std::move(*this).replace(o, n); });
+            });
+        }
+
+        inline stdx::string replace(const std::wstring& oldStr, const std::wstring& newStr) const& {
+            return with_view(oldStr.data(), oldStr.size(), [&](string_view o) {
+                return with_view(newStr.data(), newStr.size(), [&](string_view n) { return replace(o, n); });
+            });
+        }
+
+        inline stdx::string replace(const std::wstring& oldStr, const std::wstring& newStr) && {
+            return with_view(oldStr.data(), oldStr.size(), [&](string_view o) {
+                return with_view(newStr.data(), newStr.size(), [&](string_view n) { return std::move(*this).replace(o, n); });
+            });
+        }
+
+        inline stdx::string replace(const char* oldStr, const char* newStr) const& {
+            return with_view(oldStr, strlen(oldStr), [&](string_view o) {
+                return with_view(newStr, strlen(newStr), [&](string_view n) { return replace(o, n); });
+            });
+        }
+
+        inline stdx::string replace(const char* oldStr, const char* newStr) && {
+            return with_view(oldStr, strlen(oldStr), [&](string_view o) {
+                return with_view(newStr, strlen(newStr), [&](string_view n) { return std::move(*this).replace(o, n); });
+            });
+        }
+
+        inline stdx::string replace(const wchar_t* oldStr, const wchar_t* newStr) const& {
+            return with_view(oldStr, wcslen(oldStr), [&](string_view o) {
+                return with_view(newStr, wcslen(newStr), [&](string_view n) { return replace(o, n); });
+            });
+        }
+
+        inline stdx::string replace(const wchar_t* oldStr, const wchar_t* newStr) && {
+            return with_view(oldStr, wcslen(oldStr), [&](string_view o) {
+                return with_view(newStr, wcslen(newStr), [&](string_view n) { return std::move(*this).replace(o, n); });
+            });
+        }
+
+        inline bool starts_with(const stdx::string& prefix) const {
+            return view().starts_with(prefix.view());
+        }
+
+        inline bool starts_with(string_view prefix) const {
+            return view().starts_with(prefix);
+        }
+
+        inline bool ends_with(const stdx::string& suffix) const {
+            return view().ends_with(suffix.view());
+        }
+
+        inline bool ends_with(string_view suffix) const {
+            return view().ends_with(suffix);
+        }
+
+        inline void trim_start() {
+            size_t start = visit([&](const auto* p) { return detail::trim_start_index(p, m_size); });
+            if (start > 0) {
+                visit([&](auto* p) { detail::copy_units(p, p + start, m_size - start); });
+                set_length(m_size - start);
+            }
+        }
+
+        inline stdx::string trimmed_start() const& {
+            stdx::string result(*this, get_allocator());
+            result.trim_start();
+            return result;
+        }
+
+        inline stdx::string trimmed_start() && {
+            trim_start();
+            return std::move(*this);
+        }
+
+        inline void trim_end() {
+            size_t end = visit([&](const auto* p) { return detail::trim_end_index(p, m_size); });
+            set_length(end);
+        }
+
+        inline stdx::string trimmed_end() const& {
+            stdx::string result(*this, get_allocator());
+            result.trim_end();
+            return result;
+        }
+
+        inline stdx::string trimmed_end() && {
+            trim_end();
+            return std::move(*this);
+        }
+
+        inline void trim() {
+            trim_end();
+            trim_start();
+        }
+
+        inline stdx::string trimmed() const& {
+            stdx::string result(*this, get_allocator());
+            result.trim();
+            return result;
+        }
+
+        inline stdx::string trimmed() && {
+            trim();
+            return std::move(*this);
+        }
+
+        inline size_t length() const {
+            return m_size;
+        }
+
+        inline size_t index_of(char32_t c) const {
+            return visit([&](const auto* p) { return detail::find_unit(p, m_size, c, 0); });
+        }
+
+        inline size_t index_of(const stdx::string& str) const {
+            return find_from(str, 0);
+        }
+
+        inline size_t index_of(string_view str) const {
+            return find_from(str, 0);
+        }
+
+        inline size_t last_index_of(char32_t c) const {
+            return visit([&](const auto* p) { return detail::rfind_unit(p, m_size, c); });
+        }
+
+        inline size_t last_index_of(const stdx::string& str) const {
+            return view().last_index_of(str.view());
+        }
+
+        inline size_t last_index_of(string_view str) const {
+            return view().last_index_of(str);
+        }
+
+        inline std::vector<size_t> find_all(const stdx::string& str) const {
+            return view().find_all(str.view());
+        }
+
+        inline std::vector<size_t> find_all(string_view str) const {
+            return view().find_all(str);
+        }
+
+        inline search::match find_any(const search::matcher& patterns, size_t from = 0) const {
+            return view().find_any(patterns, from);
+        }
+
+        inline bool contains(char32_t c) const {
+            return index_of(c) != stdx::string::npos;
+        }
+
+        inline size_t count(char32_t c) const {
+            return view().count(c);
+        }
+
+        inline bool contains(const stdx::string& str) const {
+            return find_from(str, 0) != npos;
+        }
+
+        inline bool contains(string_view str) const {
+            return find_from(str, 0) != npos;
+        }
+
+        inline bool contains(const std::string& str) const {
+            return with_view(str.data(), str.size(), [&](string_view v) { return contains(v); });
+        }
+
+        inline bool contains(const std::wstring& str) const {
+            return with_view(str.data(), str.size(), [&](string_view v) { return contains(v); });
+        }
+
+        inline bool contains(const char* str) const {
+            return with_view(str, strlen(str), [&](string_view v) { return contains(v); });
+        }
+
+        inline bool contains(const wchar_t* str) const {
+            return with_view(str, wcslen(str), [&](string_view v) { return contains(v); });
+        }
+
+        // Lazy, allocation-free alternatives to split(); see stdx::tokenizer.
+        inline tokenizer tokenize(char32_t delimiter, split_options options = {}) const;
+        inline tokenizer tokenize(string_view separator, split_options options = {}) const;
+        inline tokenizer tokenize_any(string_view delimiters, split_options options = {}) const;
+
+        inline std::vector<stdx::string> split(char32_t delimiter) const {
+            std::vector<stdx::string> result;
+            split_into(delimiter, result);
+            return result;
+        }
+
+        // Same as split(delimiter), but refills out: the vector and the
+        // fields all live in out's memory resource.
+        inline void split(char32_t delimiter, std::pmr::vector<stdx::string>& out) const {
+            out.clear();
+            split_into(delimiter, out);
+        }
+
+        inline void pad_left(size_t totalWidth, char32_t paddingChar = U' ') & {
+            if (m_size >= totalWidth) return;
+            size_t padSize = totalWidth - m_size;
+            make_room(totalWidth, detail::width_for(paddingChar));
+            visit([&](auto* p) {
+                detail::copy_units(p + padSize, p, m_size);
+                detail::fill_units(p, paddingChar, padSize);
+            });
+            set_length(totalWidth);
+        }
+
+        inline stdx::string pad_left(size_t totalWidth, char32_t paddingChar = U' ') const& {
+            stdx::string result(*this, get_allocator());
+            result.pad_left(totalWidth, paddingChar);
+            return result;
+        }
+
+        inline stdx::string pad_left(size_t totalWidth, char32_t paddingChar = U' ') && {
+            pad_left(totalWidth, paddingChar);
+            return std::move(*this);
+        }
+
+        inline void pad_right(size_t totalWidth, char32_t paddingChar = U' ') & {
+            if (m_size >= totalWidth) return;
+            make_room(totalWidth, detail::width_for(paddingChar));
+            visit([&](auto* p) { detail::fill_units(p + m_size, paddingChar, totalWidth - m_size); });
+            set_length(totalWidth);
+        }
+
+        inline stdx::string pad_right(size_t totalWidth, char32_t paddingChar = U' ') const& {
+            stdx::string result(*this, get_allocator());
+            result.pad_right(totalWidth, paddingChar);
+            return result;
+        }
+
+        inline stdx::string pad_right(size_t totalWidth, char32_t paddingChar = U' ') && {
+            pad_right(totalWidth, paddingChar);
+            return std::move(*this);
+        }
+
+        inline void insert(size_t index, string_view str) & {
+            if (views_self(str)) { insert(index, stdx::string(str)); return; }
+            if (index > m_size) index = m_size;
+            make_room(m_size + str.m_size, str.needed_width());
+            visit([&](auto* p) { detail::copy_units(p + index + str.m_size, p + index, m_size - index); });
+            str.visit([&](const auto* src) { copy_into(index, src, str.m_size); });
+            set_length(m_size + str.m_size);
+        }
+
+        inline stdx::string insert(size_t index, string_view str) const& {
+            stdx::string result(*this, get_allocator());
+            result.insert(index, str);
+            return result;
+        }
+
+        inline stdx::string insert(size_t index, string_view str) && {
+            insert(index, str);
+            return std::move(*this);
+        }
+
+        inline void insert(size_t index, const stdx::string& str) & { insert(index, str.view()); }
+        inline stdx::string insert(size_t index, const stdx::string& str) const& { return insert(index, str.view()); }
+        inline stdx::string insert(size_t index, const stdx::string& str) && { return std::move(*this).insert(index, str.view()); }
+
+        inline void remove(size_t index, size_t count) & {
+            if (index >= m_size) return;
+            size_t rcount = std::min(count, m_size - index);
+            visit([&](auto* p) { detail::copy_units(p + index, p + index + rcount, m_size - index - rcount); });
+            set_length(m_size - rcount);
+        }
+
+        inline stdx::string remove(size_t index, size_t count) const& {
+            stdx::string result(*this, get_allocator());
+            result.remove(index, count);
+            return result;
+        }
+
+        inline stdx::string remove(size_t index, size_t count) && {
+            remove(index, count);
+            return std::move(*this);
+        }
+
+        inline char32_t at(size_t index) const {
+            return (index < m_size) ? get(index) : U'\0';
+        }
+
+        //============================
+        // Operator overloads
+        //============================
+        inline stdx::string& operator+=(const std::string& rhs) {
+            appendUtf8(rhs.data(), rhs.size());
+            return *this;
+        }
+
+        inline stdx::string& operator+=(const std::wstring& rhs) {
+            appendWstr(rhs.data(), rhs.size());
+            return *this;
+        }
+
+        inline stdx::string& operator+=(const char* rhs) {
+            appendUtf8(rhs, strlen(rhs));
+            return *this;
+        }
+
+        inline stdx::string& operator+=(const wchar_t* rhs) {
+            appendWstr(rhs, wcslen(rhs));
+            return *this;
+        }
+
+        inline stdx::string& operator+=(const stdx::string& rhs) {
+            append(rhs);
+            return *this;
+        }
+
+        inline stdx::string& operator+=(string_view rhs) {
+            append(rhs);
+            return *this;
+        }
+
+        // An lvalue left side is copied once into an exactly sized result; a
+        // temporary one (the rest of an a + b + c chain) is appended to in
+        // place. For a single exact allocation across a chain, use concat().
+        inline stdx::string operator+(const std::string& rhs) const& { return concat(*this, rhs); }
+        inline stdx::string operator+(const std::wstring& rhs) const& { return concat(*this, rhs); }
+        inline stdx::string operator+(const stdx::string& rhs) const& { return concat(*this, rhs); }
+        inline stdx::string operator+(string_view rhs) const& { return concat(*this, rhs); }
+        inline stdx::string operator+(const char* rhs) const& { return concat(*this, rhs); }
+        inline stdx::string operator+(const wchar_t* rhs) const& { return concat(*this, rhs); }
+
+        inline stdx::string operator+(const std::string& rhs) && { *this += rhs; return std::move(*this); }
+        inline stdx::string operator+(const std::wstring& rhs) && { *this += rhs; return std::move(*this); }
+        inline stdx::string operator+(const stdx::string& rhs) && { *this += rhs; return std::move(*this); }
+        inline stdx::string operator+(string_view rhs) && { *this += rhs; return std::move(*this); }
+        inline stdx::string operator+(const char* rhs) && { *this += rhs; return std::move(*this); }
+        inline stdx::string operator+(const wchar_t* rhs) && { *this += rhs; return std::move(*this); }
+
+        inline bool operator==(const stdx::string& rhs) const {
+            if (m_size != rhs.m_size) return false;
+            uint64_t h = m_hash.load(std::memory_order_relaxed), rh = rhs.m_hash.load(std::memory_order_relaxed);
+            if (h && rh && h != rh) return false;
+            return visit([&](const auto* a) {
+                return rhs.visit([&](const auto* b) { return detail::equal_units(a, b, m_size); });
+            });
+        }
+
+        inline bool operator!=(const stdx::string& rhs) const {
+            return !(*this == rhs);
+        }
+
+        inline bool operator==(string_view rhs) const {
+            return view() == rhs;
+        }
+
+        // Width-independent hash of the code points. Heap strings keep it once
+        // computed (until modified), so repeated lookups of a key cost O(1).
+        // Safe to call from several threads at once, as any const member.
+        inline size_t hash() const {
+            uint64_t h = m_hash.load(std::memory_order_relaxed);
+            if (h) return (size_t)h;
+            h = visit([&](const auto* p) { return detail::hash_code_points(p, m_size); });
+            // the cache is a single word holding nothing but the hash, so
+            // racing callers store the same value and relaxed order is enough
+            if (!is_local()) m_hash.store(h, std::memory_order_relaxed);
+            return (size_t)h;
+        }
+
+        inline bool operator!=(string_view rhs) const {
+            return !(*this == rhs);
+        }
+
+        // Encoded text is decoded while comparing; see string_view::equals.
+        inline bool operator==(const std::string& rhs) const {
+            return view().equals(rhs.data(), rhs.size());
+        }
+
+        inline bool operator!=(const std::string& rhs) const {
+            return !(*this == rhs);
+        }
+
+        inline bool operator==(const std::wstring& rhs) const {
+            return view().equals(rhs.data(), rhs.size());
+        }
+
+        inline bool operator!=(const std::wstring& rhs) const {
+            return !(*this == rhs);
+        }
+
+        inline bool operator==(const char* rhs) const { return view() == rhs; }
+        inline bool operator!=(const char* rhs) const { return !(*this == rhs); }
+        inline bool operator==(const wchar_t* rhs) const { return view() == rhs; }
+        inline bool operator!=(const wchar_t* rhs) const { return !(*this == rhs); }
+
+        // Ordinal order by code point value; see string_view::compare.
+        inline int compare(const stdx::string& other) const { return view().compare(other.view()); }
+        inline int compare(string_view other) const { return view().compare(other); }
+
+        inline bool operator<(const stdx::string& rhs) const { return compare(rhs) < 0; }
+        inline bool operator<=(const stdx::string& rhs) const { return compare(rhs) <= 0; }
+        inline bool operator>(const stdx::string& rhs) const { return compare(rhs) > 0; }
+        inline bool operator>=(const stdx::string& rhs) const { return compare(rhs) >= 0; }
+        inline bool operator<(string_view rhs) const { return compare(rhs) < 0; }
+        inline bool operator<=(string_view rhs) const { return compare(rhs) <= 0; }
+        inline bool operator>(string_view rhs) const { return compare(rhs) > 0; }
+        inline bool operator>=(string_view rhs) const { return compare(rhs) >= 0; }
+#if defined(STDX_STRING_THREE_WAY)
+        inline std::strong_ordering operator<=>(const stdx::string& rhs) const { return compare(rhs) <=> 0; }
+        inline std::strong_ordering operator<=>(string_view rhs) const { return compare(rhs) <=> 0; }
+#endif
+
+        inline reference operator[](size_t index) {
+            return reference(this, index);
+        }
+
+        inline char32_t operator[](size_t index) const {
+            return get(index);
+        }
+
+        inline iterator begin() { return iterator(this, 0); }
+        inline iterator end() { return iterator(this, m_size); }
+        inline const_iterator begin() const { return const_iterator(this, 0); }
+        inline const_iterator end() const { return const_iterator(this, m_size); }
+        inline const_iterator cbegin() const { return const_iterator(this, 0); }
+        inline const_iterator cend() const { return const_iterator(this, m_size); }
+
+    private:
+        friend class string_view;
+
+        // Short strings live in m_local; longer ones on the heap, with the
+        // heap capacity (in units) stashed in m_local's first bytes. Either way m_ptr holds capacity + 1
+        // units so the contents stay terminated.
+        static constexpr size_t local_bytes = 32;
+
+        struct cstr_cache {
+            explicit cstr_cache(std::pmr::memory_resource* r) : u8(r), u16(r), u32(r) {}
+
+            std::pmr::string u8;
+            std::pmr::wstring u16;
+            std::pmr::u32string u32;
+        };
+
+        // The cache lives in the resource its buffers use.
+        struct cstr_cache_deleter {
+            inline void operator()(cstr_cache* c) const {
+                std::pmr::memory_resource* r = c->u8.get_allocator().resource();
+                c->~cstr_cache();
+                r->deallocate(c, sizeof(cstr_cache), alignof(cstr_cache));
+            }
+        };
+
+        unsigned char* m_ptr = m_local;
+        size_t m_size = 0;
+        alignas(size_t) unsigned char m_local[local_bytes] = {};
+        mutable std::unique_ptr<cstr_cache, cstr_cache_deleter> m_cache; // c_str() buffers, made on first use
+        std::pmr::memory_resource* m_resource = nullptr; // nullptr: ::operator new / delete
+        unsigned char m_width = 1;
+        mutable std::atomic<uint64_t> m_hash{ 0 }; // heap strings only; 0: not cached; cleared by any write
+
+        inline bool is_local() const { return m_ptr == m_local; }
+
+        inline bool views_self(string_view v) const { return views_self(v.m_ptr); }
+
+        // p points into this string's units, as c_str() pointers may.
+        inline bool views_self(const void* p) const {
+            uintptr_t at = (uintptr_t)p, base = (uintptr_t)m_ptr;
+            return at >= base && at <= base + m_size * m_width;
+        }
+
+        inline size_t heap_cap() const {
+            size_t cap;
+            memcpy(&cap, m_local, sizeof(cap));
+            return cap;
+        }
+
+        inline cstr_cache& cache() const {
+            if (!m_cache) {
+                std::pmr::memory_resource* r = get_allocator().resource();
+                m_cache.reset(new (r->allocate(sizeof(cstr_cache), alignof(cstr_cache))) cstr_cache(r));
+            }
+            return *m_cache;
+        }
+
+        static allocator_type default_allocator() { return allocator_type(std::pmr::new_delete_resource()); }
+
+        static std::pmr::memory_resource* resource_of(const allocator_type& alloc) {
+            return alloc.resource() == std::pmr::new_delete_resource() ? nullptr : alloc.resource();
+        }
+
+        inline unsigned char* allocate(size_t bytes) const {
+            if (m_resource) return (unsigned char*)m_resource->allocate(bytes, alignof(char32_t));
+            return (unsigned char*)::operator new(bytes);
+        }
+
+        // bytes: what allocate() was given for p.
+        inline void deallocate(unsigned char* p, size_t bytes) const {
+            if (m_resource) m_resource->deallocate(p, bytes, alignof(char32_t));
+            else ::operator delete(p);
+        }
+
+        // Frees the heap buffer, if there is one.
+        inline void release() {
+            if (!is_local()) deallocate(m_ptr, (heap_cap() + 1) * m_width);
+        }
+
+        // Moves other's contents into this (whose buffer is already released).
+        inline void take(string& other) noexcept {
+            m_size = other.m_size;
+            m_width = other.m_width;
+            memcpy(m_local, other.m_local, local_bytes);
+            m_ptr = other.is_local() ? m_local : other.m_ptr;
+            m_cache = std::move(other.m_cache);
+            m_hash.store(other.m_hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.m_ptr = other.m_local;
+            other.m_width = 1;
+            other.set_length(0);
+        }
+
+        // Calls f with a typed pointer to the units of the current width.
+        // Every write goes through here, which is what drops the cached hash.
+        template<typename F>
+        inline auto visit(F&& f) -> decltype(f((unsigned char*)nullptr)) {
+            m_hash.store(0, std::memory_order_relaxed);
+            return detail::visit_units(m_ptr, m_width, std::forward<F>(f));
+        }
+
+        // (the return type is probed with a mutable pointer on purpose: probing
+        // a writing lambda with a const one would be a hard error)
+        template<typename F>
+        inline auto visit(F&& f) const -> decltype(f((unsigned char*)nullptr)) {
+            return detail::visit_units((const unsigned char*)m_ptr, m_width, std::forward<F>(f));
+        }
+
+        inline char32_t get(size_t i) const {
+            return visit([&](const auto* p) { return (char32_t)p[i]; });
+        }
+
+        // caller has made sure the storage is wide enough for c
+        inline void put(size_t i, char32_t c) {
+            visit([&](auto* p) { p[i] = (std::remove_pointer_t<decltype(p)>)c; });
+        }
+
+        inline void set(size_t i, char32_t c) {
+            make_room(m_size, detail::width_for(c));
+            put(i, c);
+        }
+
+        inline char32_t bits() const {
+            return visit([&](const auto* p) { return detail::code_point_bits(p, m_size); });
+        }
+
+        // Narrowest width that holds this string; only scans when it is wide.
+        inline unsigned needed_width() const {
+            return m_width == 1 ? 1 : detail::width_for(bits());
+        }
+
+        // Writes the Kind mapping of src[i, n) to dst[i, n), stopping early
+        // (and returning where) at a code point whose mapping needs wider
+        // units than Dst. src and dst may be the same buffer.
+        template<unicode::case_kind Kind, typename Dst, typename Src>
+        static size_t map_case_units(Dst* dst, const Src* src, size_t i, size_t n) {
+            for (; i < n; ++i) {
+                if constexpr (sizeof(Dst) == 1 && sizeof(Src) == 1) {
+                    i += unicode::map_ascii<Kind>((const unsigned char*)src + i, (unsigned char*)dst + i, n - i);
+                    if (i == n) break;
                 }
+                char32_t c = unicode::map_case<Kind>((char32_t)src[i]);
+                if (c > detail::unit_max<Dst>()) return i;
+                dst[i] = (Dst)c;
+            }
+            return n;
+        }
+
+        template<unicode::case_kind Kind>
+        inline void map_case_in_place() {
+            size_t i = 0;
+            while ((i = visit([&](auto* p) { return map_case_units<Kind>(p, p, i, m_size); })) < m_size) {
+                // e.g. U+00FF -> U+0178 leaves Latin-1
+                make_room(m_size, detail::width_for(unicode::map_case<Kind>(get(i))));
+            }
+        }
+
+        template<unicode::case_kind Kind>
+        inline stdx::string mapped_case() const {
+            stdx::string result(get_allocator());
+            result.make_room(m_size, m_width);
+            result.set_length(m_size);
+            size_t i = 0;
+            while ((i = result.visit([&](auto* dst) {
+                return visit([&](const auto* src) { return map_case_units<Kind>(dst, src, i, m_size); });
+            })) < m_size) {
+                result.make_room(m_size, detail::width_for(unicode::map_case<Kind>(get(i))));
+            }
+            return result;
+        }
+
+        inline void set_length(size_t n) {
+            m_size = n;
+            put(n, U'\0');
+        }
+
+        // Ensures room for n code points at (at least) the given width.
+        inline void make_room(size_t n, unsigned width) {
+            if (width < m_width) width = m_width;
+            size_t cap = capacity();
+            if (n <= cap && width == m_width) return;
+            // grow geometrically; a pure widening keeps just what is needed
+            reallocate(n > cap ? std::max(n, cap * 2) : std::max(n, m_size), width);
+        }
+
+        inline void reallocate(size_t cap, unsigned width) {
+            bool wasLocal = is_local();
+            bool toLocal = (cap + 1) * width <= local_bytes;
+            unsigned char saved[local_bytes];
+            const unsigned char* src = m_ptr;
+            if (wasLocal && toLocal) {
+                memcpy(saved, m_local, local_bytes);
+                src = saved;
+            }
+            // read before a move back into m_local overwrites the stashed capacity
+            size_t oldBytes = wasLocal ? 0 : (heap_cap() + 1) * m_width;
+            unsigned char* p = toLocal ? m_local : allocate((cap + 1) * width);
+            detail::visit_units(src, m_width, [&](const auto* from) {
+                detail::visit_units(p, width, [&](auto* to) { detail::copy_units(to, from, m_size); });
+            });
+            if (!wasLocal) deallocate(m_ptr, oldBytes);
+            m_ptr = p;
+            m_width = (unsigned char)width;
+            if (!toLocal) memcpy(m_local, &cap, sizeof(cap));
+            set_length(m_size);
+        }
+
+        template<typename Src>
+        inline void copy_into(size_t pos, const Src* src, size_t n) {
+            visit([&](auto* dst) { detail::copy_units(dst + pos, src, n); });
+        }
+
+        // Replaces the contents, choosing the narrowest width for them.
+        template<typename Src>
+        inline void assign_code_points(const Src* src, size_t n) {
+            unsigned w = sizeof(Src) == 1 ? 1 : detail::width_for(detail::code_point_bits(src, n));
+            m_size = 0;
+            make_room(n, w);
+            copy_into(0, src, n);
+            set_length(n);
+        }
+
+        // Fields of a std::vector take this string's resource; a pmr vector
+        // hands its own to the fields it constructs.
+        template<typename Vector>
+        inline void split_into(char32_t delimiter, Vector& out) const {
+            if (m_size == 0) return;
+            // sized up front: growing would move every field built so far
+            out.reserve(out.size() + count(delimiter) + 1);
+            auto field = [&](const auto* p, size_t n) {
+                if constexpr (std::is_same_v<Vector, std::pmr::vector<stdx::string>>) out.emplace_back();
+                else out.emplace_back(get_allocator());
+                out.back().assign_code_points(p, n);
+            };
+            visit([&](const auto* p) {
+                size_t start = 0, hit;
+                while ((hit = detail::find_unit(p, m_size, delimiter, start)) != npos) {
+                    field(p + start, hit - start);
+                    start = hit + 1;
+                }
+                if (start < m_size) field(p + start, m_size - start);
+            });
+        }
+
+        inline void append_range(const stdx::string& src, size_t pos, size_t n) {
+            append(src.view(pos, n));
+        }
+
+        inline size_t find_from(string_view needle, size_t from) const {
+            return view().find_from(needle, from);
+        }
+
+        const char32_t* select_cstr(utf32_t*) const
+        {
+            if (m_width == 4) return (const char32_t*)m_ptr;
+            std::pmr::u32string& buf32 = cache().u32;
+            buf32.resize(m_size);
+            visit([&](const auto* p) { detail::copy_units(&buf32[0], p, m_size); });
+            return buf32.c_str();
+        }
+
+        const char* select_cstr(utf8_t*) const
+        {
+            // ASCII held as Latin-1 is already valid, terminated UTF-8
+            if (m_width == 1 && utf::utf8_length_of(m_ptr, m_size) == m_size) return (const char*)m_ptr;
+            // encode in place so buf8 keeps its capacity between calls
+            std::pmr::string& buf8 = cache().u8;
+            encodeUtf8(buf8);
+            return buf8.c_str();
+        }
+
+        const wchar_t* select_cstr(utf16_t*) const
+        {
+            std::pmr::wstring& buf16 = cache().u16;
+            visit([&](const auto* p) {
+#ifdef _WIN32
+                buf16.resize(utf::utf16_length_of(p, m_size));
+                utf::encode_utf16(p, m_size, &buf16[0]);
+#else
+                buf16.resize(m_size);
+                detail::copy_units(&buf16[0], p, m_size);
+#endif
+            });
+            return buf16.c_str();
+        }
+
+        // utf8 -> code points, decoded straight into storage
+        void fromUtf8(const char* s, size_t n) {
+            m_size = 0;
+            appendUtf8(s, n);
+        }
+
+        void appendUtf8(const char* s, size_t n) {
+            if (n && views_self(s)) {
+                // e.g. t += t.c_str<utf8_t>(): making room may free s
+                std::string copy(s, n);
+                appendUtf8(copy.data(), n);
+                return;
+            }
+            size_t chunks = utf::parallel_chunks(n);
+            if (chunks > 1) {
+                appendUtf8Parallel(s, n, chunks);
+                return;
+            }
+            utf::utf_info info = utf::inspect_utf8(s, n);
+            make_room(m_size + info.code_points, detail::width_for(info.bits));
+            visit([&](auto* p) { utf::decode_utf8(s, n, p + m_size); });
+            set_length(m_size + info.code_points);
+        }
+
+        // Measures the chunks concurrently, makes room once, then decodes each
+        // chunk straight into its own slice of storage.
+        void appendUtf8Parallel(const char* s, size_t n, size_t chunks) {
+            std::vector<size_t> bounds = utf::split_utf8(s, n, chunks);
+            std::vector<utf::utf_info> info(chunks);
+            utf::parallel_for(chunks, [&](size_t i) { info[i] = utf::inspect_utf8(s + bounds[i], bounds[i + 1] - bounds[i]); });
+
+            std::vector<size_t> offsets(chunks + 1, m_size);
+            char32_t bits = 0;
+            for (size_t i = 0; i < chunks; ++i) {
+                offsets[i + 1] = offsets[i] + info[i].code_points;
+                bits |= info[i].bits;
+            }
+            make_room(offsets[chunks], detail::width_for(bits));
+            visit([&](auto* p) {
+                utf::parallel_for(chunks, [&](size_t i) { utf::decode_utf8(s + bounds[i], bounds[i + 1] - bounds[i], p + offsets[i]); });
+            });
+            set_length(offsets[chunks]);
+        }
+
+        // utf16 or utf32 platform dependent; all n units are kept, embedded
+        // NULs included, as fromUtf8 keeps them
+        void fromWstr(const wchar_t* w, size_t n) {
+            m_size = 0;
+            appendWstr(w, n);
+        }
 
-                // lone surrogate or BMP
-                out.push_back((char32_t)c);
+        void appendWstr(const wchar_t* w, size_t n) {
+            if (n && views_self(w)) {
+                std::wstring copy(w, n);
+                appendWstr(copy.data(), n);
+                return;
             }
+#ifdef _WIN32
+            utf::utf_info info = utf::inspect_utf16(w, n);
+            make_room(m_size + info.code_points, detail::width_for(info.bits));
+            visit([&](auto* p) { utf::decode_utf16(w, n, p + m_size); });
+            set_length(m_size + info.code_points);
+#else
+            make_room(m_size + n, detail::width_for(detail::code_point_bits(w, n)));
+            copy_into(m_size, w, n);
+            set_length(m_size + n);
+#endif
+        }
+
+        // code points -> utf8, sized exactly and encoded straight from storage
+        std::string toUtf8() const {
+            std::string s;
+            encodeUtf8(s);
+            return s;
+        }
+
+        // Big strings are encoded in chunks of code points, measured and then
+        // encoded concurrently, each into its own slice of out.
+        template<typename Out>
+        void encodeUtf8(Out& out) const {
+            size_t chunks = utf::parallel_chunks(m_size);
+            visit([&](const auto* p) {
+                if (chunks == 1) {
+                    out.resize(utf::utf8_length_of(p, m_size));
+                    utf::encode_utf8(p, m_size, &out[0]);
+                    return;
+                }
+                auto first = [&](size_t i) { return i == chunks ? m_size : m_size / chunks * i; };
+                std::vector<size_t> offsets(chunks + 1, 0);
+                utf::parallel_for(chunks, [&](size_t i) { offsets[i + 1] = utf::utf8_length_of(p + first(i), first(i + 1) - first(i)); });
+                for (size_t i = 0; i < chunks; ++i) offsets[i + 1] += offsets[i];
+                out.resize(offsets[chunks]);
+                utf::parallel_for(chunks, [&](size_t i) { utf::encode_utf8(p + first(i), first(i + 1) - first(i), &out[0] + offsets[i]); });
+            });
+        }
+
+        // code points -> wstring
+        std::wstring toWstr() const {
+            return visit([&](const auto* p) {
+#ifdef _WIN32
+                std::wstring w(utf::utf16_length_of(p, m_size), L'\0');
+                utf::encode_utf16(p, m_size, &w[0]);
+#else
+                std::wstring w(m_size, L'\0');
+                detail::copy_units(&w[0], p, m_size);
+#endif
+                return w;
+            });
+        }
+
+        static std::u32string from_wstring(const std::wstring& w)
+        {
+#ifdef _WIN32
+            std::u32string out(utf::inspect_utf16(w.data(), w.size()).code_points, U'\0');
+            utf::decode_utf16(w.data(), w.size(), &out[0]);
+            return out;
+#else
+            return std::u32string(w.begin(), w.end());
+#endif
+        }
+
+        static std::wstring to_wstring(const std::u32string& u)
+        {
+#ifdef _WIN32
+            std::wstring w(utf::utf16_length_of(u.data(), u.size()), L'\0');
+            utf::encode_utf16(u.data(), u.size(), &w[0]);
+            return w;
+#else
+            return std::wstring(u.begin(), u.end());
+#endif
+        }
+
+        static std::u32string utf8_to_utf32(const std::string& s)
+        {
+            std::u32string out(utf::inspect_utf8(s.data(), s.size()).code_points, U'\0');
+            utf::decode_utf8(s.data(), s.size(), &out[0]);
+            return out;
+        }
 
+        static std::string utf32_to_utf8(const std::u32string& s)
+        {
+            std::string out(utf::utf8_length_of(s.data(), s.size()), '\0');
+            utf::encode_utf8(s.data(), s.size(), &out[0]);
+            return out;
+        }
+
+        static std::u32string utf16_to_utf32(const std::u16string& in)
+        {
+            std::u32string out(utf::inspect_utf16(in.data(), in.size()).code_points, U'\0');
+            utf::decode_utf16(in.data(), in.size(), &out[0]);
             return out;
         }
 
         // UTF32 -> UTF16
         static std::u16string utf32_to_utf16(const std::u32string& in)
         {
-            std::u16string out;
-            out.reserve(in.size());
-
-            for (char32_t cp : in)
-            {
-                if (cp <= 0xFFFF)
-                {
-                    out.push_back((char16_t)cp);
-                }
-                else
-                {
-                    cp -= 0x10000;
-                    char16_t high = 0xD800 + ((cp >> 10) & 0x3FF);
-                    char16_t low = 0xDC00 + (cp & 0x3FF);
-                    out.push_back(high);
-                    out.push_back(low);
-                }
-            }
-
+            std::u16string out(utf::utf16_length_of(in.data(), in.size()), u'\0');
+            utf::encode_utf16(in.data(), in.size(), &out[0]);
             return out;
         }
 
@@ -693,62 +1951,760 @@ namespace stdx {
         }
 
         inline static bool is_empty_or_whitespace(const stdx::string& s) {
-            for (char32_t c : s) {
-                if (!(c == U' ' || c == U'\t' || c == U'\n' || c == U'\r' || c == U'\f' || c == U'\v'))
-                    return false;
-            }
-            return true;
+            return s.visit([&](const auto* p) { return scan::find_not(p, s.m_size, scan::white_spaces) == npos; });
         }
 
-		//============================
+        //============================
         // Helpers
-		//============================
+        //============================
+        // Same text as std::to_string (floating point as "%f"), written with
+        // std::to_chars without an intermediate std::string.
         template<typename T>
         inline static stdx::string to_string(T value) {
-			static_assert(std::is_arithmetic_v<T>, "to_string only supports arithmetic types");
-            return stdx::string(std::to_string(value));
-		}
+            static_assert(std::is_arithmetic_v<T>, "to_string only supports arithmetic types");
+            stdx::string result;
+            if constexpr (std::is_floating_point_v<T>) result.append_number(value, std::chars_format::fixed, 6);
+            else result.append_number(value);
+            return result;
+        }
+
+        // Integers in base 2..36 (lowercase digits, '-' for negatives).
+        template<typename T>
+        inline static stdx::string to_string(T value, int base) {
+            static_assert(std::is_integral_v<T>, "a base only applies to integers");
+            stdx::string result;
+            result.append_number(value, base);
+            return result;
+        }
 
         inline static stdx::string to_string(double value, int precision) {
-            char buf[64];
-            snprintf(buf, sizeof(buf), "%.*f", precision, value);
-            return stdx::string(buf);
+            stdx::string result;
+            result.append_number(value, std::chars_format::fixed, precision);
+            return result;
         }
 
         inline static stdx::string to_string(float value, int precision) {
-            char buf[64];
-            snprintf(buf, sizeof(buf), "%.*f", precision, value);
-            return stdx::string(buf);
+            stdx::string result;
+            result.append_number(value, std::chars_format::fixed, precision);
+            return result;
         }
 
-        inline static stdx::string join(const std::vector<stdx::string>& parts, const stdx::string& delimiter) {
-            if (parts.empty()) return stdx::string();
-            stdx::string result = parts[0];
-            for (size_t i = 1; i < parts.size(); ++i) {
-                result += delimiter;
-                result += parts[i];
-            }
+        template<typename T>
+        inline static stdx::string to_string(T value, std::chars_format format, int precision) {
+            static_assert(std::is_floating_point_v<T>, "a format only applies to floating point");
+            stdx::string result;
+            result.append_number(value, format, precision);
             return result;
-		}
+        }
+
+        // Appends the digits of a number without going through std::string.
+        // Integers are decimal (or the given base); floating point is the
+        // shortest text that round-trips unless a format is given.
+        template<typename T>
+        inline stdx::string& append_number(T value) {
+            static_assert(std::is_arithmetic_v<T>, "append_number only supports arithmetic types");
+            if constexpr (std::is_floating_point_v<T>) return append_chars([&](char* f, char* l) { return float_chars(f, l, value, std::chars_format{}, -1); });
+            else return append_chars([&](char* f, char* l) { return std::to_chars(f, l, +value); });
+        }
+
+        template<typename T>
+        inline stdx::string& append_number(T value, int base) {
+            static_assert(std::is_integral_v<T>, "a base only applies to integers");
+            return append_chars([&](char* f, char* l) { return std::to_chars(f, l, +value, base); });
+        }
+
+        template<typename T>
+        inline stdx::string& append_number(T value, std::chars_format format) {
+            static_assert(std::is_floating_point_v<T>, "a format only applies to floating point");
+            return append_chars([&](char* f, char* l) { return float_chars(f, l, value, format, -1); });
+        }
 
-        inline static stdx::string join(const std::vector<std::string>& parts, const stdx::string& delimiter) {
-            if (parts.empty()) return stdx::string();
-            stdx::string result = stdx::string(parts[0]);
-            for (size_t i = 1; i < parts.size(); ++i) {
-                result += delimiter;
-                result += stdx::string(parts[i]);
+        template<typename T>
+        inline stdx::string& append_number(T value, std::chars_format format, int precision) {
+            static_assert(std::is_floating_point_v<T>, "a format only applies to floating point");
+            return append_chars([&](char* f, char* l) { return float_chars(f, l, value, format, precision); });
+        }
+
+        template<typename T>
+        inline std::optional<T> try_parse() const { return view().template try_parse<T>(); }
+
+        template<typename T>
+        inline std::optional<T> try_parse(int base) const { return view().template try_parse<T>(base); }
+
+        template<typename T>
+        inline T parse() const { return view().template parse<T>(); }
+
+        template<typename T>
+        inline T parse(int base) const { return view().template parse<T>(base); }
+
+        // Concatenates any mix of stdx::string, string_view, char32_t, UTF-8
+        // (const char*, std::string) and wide text into one exactly sized
+        // allocation: every part is measured first, then written in place.
+        template<typename... Parts>
+        inline static stdx::string concat(const Parts&... parts) {
+            static_assert((detail::is_text_part<Parts> && ...), "concat parts are text or characters; format numbers with to_string");
+            stdx::string result;
+            if constexpr (sizeof...(Parts) > 0) {
+                utf::utf_info infos[] = { part_info(parts)... };
+                size_t total = 0;
+                char32_t bits = 0;
+                for (const auto& info : infos) {
+                    total += info.code_points;
+                    bits |= info.bits;
+                }
+                result.make_room(total, detail::width_for(bits));
+                result.visit([&](auto* dst) { ((dst = write_part(dst, parts)), ...); });
+                result.set_length(total);
             }
             return result;
-		}
+        }
+
+        inline static stdx::string join(const std::vector<stdx::string>& parts, const stdx::string& delimiter, const allocator_type& alloc = default_allocator()) {
+            return join_parts(parts, delimiter.view(), alloc);
+        }
+
+        inline static stdx::string join(const std::vector<string_view>& parts, const stdx::string& delimiter, const allocator_type& alloc = default_allocator()) {
+            return join_parts(parts, delimiter.view(), alloc);
+        }
+
+        inline static stdx::string join(const std::vector<std::string>& parts, const stdx::string& delimiter, const allocator_type& alloc = default_allocator()) {
+            return join_parts(parts, delimiter.view(), alloc);
+        }
+
+        inline static stdx::string join(const std::vector<std::wstring>& parts, const stdx::string& delimiter, const allocator_type& alloc = default_allocator()) {
+            return join_parts(parts, delimiter.view(), alloc);
+        }
+
+        inline static stdx::string join(const std::vector<stdx::string>& parts, string_view delimiter, const allocator_type& alloc = default_allocator()) {
+            return join_parts(parts, delimiter, alloc);
+        }
+
+        inline static stdx::string join(const std::vector<string_view>& parts, string_view delimiter, const allocator_type& alloc = default_allocator()) {
+            return join_parts(parts, delimiter, alloc);
+        }
+
+        inline static stdx::string join(const std::vector<std::string>& parts, string_view delimiter, const allocator_type& alloc = default_allocator()) {
+            return join_parts(parts, delimiter, alloc);
+        }
+
+        inline static stdx::string join(const std::vector<std::wstring>& parts, string_view delimiter, const allocator_type& alloc = default_allocator()) {
+            return join_parts(parts, delimiter, alloc);
+        }
+
+        // Sorts into operator< order; for large lists, faster than std::sort
+        // with a comparator. Each pass packs the next few code points of
+        // every string in a range into one 64-bit key (a prefix cache) and
+        // sorts the range on those integers alone; only runs that tie go on
+        // to the following code points. Not stable, as std::sort.
+        template<typename Alloc>
+        inline static void sort(std::vector<stdx::string, Alloc>& strings) {
+            size_t n = strings.size();
+            if (n <= sort_small) {
+                std::sort(strings.begin(), strings.end());
+                return;
+            }
+            // move each string into place along the permutation's cycles
+            std::vector<size_t> order = sort_order(strings.data(), n);
+            for (size_t i = 0; i < n; ++i) {
+                if (order[i] == i) continue;
+                stdx::string held(std::move(strings[i]));
+                size_t j = i;
+                while (order[j] != i) {
+                    size_t next = order[j];
+                    strings[j] = std::move(strings[next]);
+                    order[j] = j;
+                    j = next;
+                }
+                strings[j] = std::move(held);
+                order[j] = j;
+            }
+        }
+
+    private:
+        friend class string_builder;
+
+        //============================
+        // concat/join parts
+        //============================
+        // part_info() measures a part (code points, and bits enough to pick
+        // the width); write_part() stores it at dst and returns the end.
+        static char32_t width_bits(unsigned width) {
+            return width == 1 ? 0 : width == 2 ? 0x100 : 0x10000;
+        }
+
+        static utf::utf_info part_info(string_view s) { return { s.m_size, width_bits(s.m_width) }; }
+        static utf::utf_info part_info(const stdx::string& s) { return { s.m_size, width_bits(s.m_width) }; }
+        static utf::utf_info part_info(char32_t c) { return { 1, c }; }
+        static utf::utf_info part_info(char c) { return { 1, (unsigned char)c }; }
+        static utf::utf_info part_info(const std::string& s) { return utf::inspect_utf8(s.data(), s.size()); }
+        static utf::utf_info part_info(const char* s) { return utf::inspect_utf8(s, strlen(s)); }
+        static utf::utf_info part_info(const std::wstring& s) { return wide_info(s.data(), s.size()); }
+        static utf::utf_info part_info(const wchar_t* s) { return wide_info(s, wcslen(s)); }
+
+        static utf::utf_info wide_info(const wchar_t* w, size_t n) {
+#ifdef _WIN32
+            return utf::inspect_utf16(w, n);
+#else
+            return { n, detail::code_point_bits(w, n) };
+#endif
+        }
+
+        template<typename Unit>
+        static Unit* write_part(Unit* dst, string_view s) {
+            s.visit([&](const auto* p) { detail::copy_units(dst, p, s.m_size); });
+            return dst + s.m_size;
+        }
 
-        inline static stdx::string join(const std::vector<std::wstring>& parts, const stdx::string& delimiter) {
-            if (parts.empty()) return stdx::string();
-            stdx::string result = stdx::string(parts[0]);
-            for (size_t i = 1; i < parts.size(); ++i) {
-                result += delimiter;
-                result += stdx::string(parts[i]);
+        template<typename Unit>
+        static Unit* write_part(Unit* dst, const stdx::string& s) { return write_part(dst, s.view()); }
+
+        template<typename Unit>
+        static Unit* write_part(Unit* dst, char32_t c) {
+            *dst = (Unit)c;
+            return dst + 1;
+        }
+
+        template<typename Unit>
+        static Unit* write_part(Unit* dst, char c) { return write_part(dst, (char32_t)(unsigned char)c); }
+
+        template<typename Unit>
+        static Unit* write_part(Unit* dst, const std::string& s) { return dst + utf::decode_utf8(s.data(), s.size(), dst); }
+
+        template<typename Unit>
+        static Unit* write_part(Unit* dst, const char* s) { return dst + utf::decode_utf8(s, strlen(s), dst); }
+
+        template<typename Unit>
+        static Unit* write_part(Unit* dst, const std::wstring& s) { return write_wide(dst, s.data(), s.size()); }
+
+        template<typename Unit>
+        static Unit* write_part(Unit* dst, const wchar_t* s) { return write_wide(dst, s, wcslen(s)); }
+
+        // std::to_chars for floating point; format {} is the overload without
+        // one, precision < 0 the overloads without one.
+        template<typename T>
+        static std::to_chars_result float_chars(char* first, char* last, T value, std::chars_format format, int precision) {
+#if defined(STDX_FLOAT_TO_CHARS)
+            if (format == std::chars_format{}) return std::to_chars(first, last, value);
+            if (precision < 0) return std::to_chars(first, last, value, format);
+            return std::to_chars(first, last, value, format, precision);
+#else
+            return detail::float_to_chars(first, last, value, format, precision);
+#endif
+        }
+
+        // Runs a to_chars call on a stack buffer and appends the ASCII it
+        // wrote; only fixed notation of huge values or precisions outgrows it.
+        template<typename Convert>
+        inline stdx::string& append_chars(Convert&& convert) {
+            char local[128];
+            std::to_chars_result r = convert(local, local + sizeof(local));
+            if (r.ec == std::errc()) {
+                append(string_view((const unsigned char*)local, (size_t)(r.ptr - local)));
+                return *this;
+            }
+            for (size_t size = 1024;; size *= 4) {
+                std::unique_ptr<char[]> buf(new char[size]);
+                r = convert(buf.get(), buf.get() + size);
+                if (r.ec == std::errc()) {
+                    append(string_view((const unsigned char*)buf.get(), (size_t)(r.ptr - buf.get())));
+                    return *this;
+                }
+            }
+        }
+
+        // Hands f the code points of UTF-8 or wide text as a view: ASCII is
+        // viewed in place and other short text is decoded onto the stack, so
+        // only long non-ASCII needles cost a temporary.
+        static constexpr size_t stack_code_points = 64;
+
+        template<typename F>
+        static auto with_view(const char* s, size_t n, F&& f) -> decltype(f(string_view())) {
+            const unsigned char* p = (const unsigned char*)s;
+            if (utf::utf8_length_of(p, n) == n) return f(string_view(p, n));
+            if (n <= stack_code_points) {
+                char32_t buf[stack_code_points];
+                return f(string_view(buf, utf::decode_utf8(s, n, buf)));
+            }
+            stdx::string tmp;
+            tmp.appendUtf8(s, n);
+            return f(tmp.view());
+        }
+
+        template<typename F>
+        static auto with_view(const wchar_t* w, size_t n, F&& f) -> decltype(f(string_view())) {
+            if (n <= stack_code_points) {
+                char32_t buf[stack_code_points];
+                return f(string_view(buf, (size_t)(write_wide(buf, w, n) - buf)));
+            }
+            stdx::string tmp;
+            tmp.appendWstr(w, n);
+            return f(tmp.view());
+        }
+
+        template<typename Unit>
+        static Unit* write_wide(Unit* dst, const wchar_t* w, size_t n) {
+#ifdef _WIN32
+            return dst + utf::decode_utf16(w, n, dst);
+#else
+            detail::copy_units(dst, w, n);
+            return dst + n;
+#endif
+        }
+
+        // Ranges this small are finished with comparisons instead.
+        static constexpr size_t sort_small = 16;
+
+        // Two words of prefix: 14 Latin-1 code points, 6 below U+10FFFF.
+        struct sort_key {
+            uint64_t high, low;
+            size_t index;
+
+            inline bool operator<(const sort_key& rhs) const { return high != rhs.high ? high < rhs.high : low < rhs.low; }
+            inline bool operator==(const sort_key& rhs) const { return high == rhs.high && low == rhs.low; }
+        };
+
+        // Code points depth, depth + 1, ... as fields of bits bits, each
+        // holding the code point + 1 (0 past the end), first one highest.
+        inline void sort_prefix(sort_key& key, size_t depth, unsigned per, unsigned bits) const {
+            visit([&](const auto* p) {
+                auto pack = [&](size_t from) {
+                    uint64_t word = 0;
+                    for (unsigned j = 0; j < per; ++j) {
+                        size_t at = from + j;
+                        word = (word << bits) | (at < m_size ? (uint64_t)p[at] + 1 : 0);
+                    }
+                    return word;
+                };
+                key.high = pack(depth);
+                key.low = depth + per < m_size ? pack(depth + per) : 0;
+            });
+        }
+
+        // Indices of strings[0, n) in sorted order.
+        static std::vector<size_t> sort_order(const stdx::string* strings, size_t n) {
+            // fields just wide enough for the largest code point: 7 per key
+            // for Latin-1, 3 for anything up to U+10FFFF
+            char32_t top = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const stdx::string& s = strings[i];
+                if (s.m_width < 4) top = std::max<char32_t>(top, s.m_width == 1 ? 0xFF : 0xFFFF);
+                else s.visit([&](const auto* p) { for (size_t j = 0; j < s.m_size; ++j) top = std::max<char32_t>(top, p[j]); });
             }
+            unsigned bits = 1;
+            while (((uint64_t)top + 1) >> bits) ++bits;
+            unsigned per = 64 / bits;
+            uint64_t last_field = ((uint64_t)1 << bits) - 1;
+
+            std::vector<sort_key> keys(n);
+            for (size_t i = 0; i < n; ++i) keys[i].index = i;
+
+            struct range { size_t first, last, depth; };
+            std::vector<range> pending = { { 0, n, 0 } };
+            while (!pending.empty()) {
+                range r = pending.back();
+                pending.pop_back();
+                sort_key* first = keys.data() + r.first;
+                sort_key* last = keys.data() + r.last;
+                if (r.last - r.first <= sort_small) {
+                    std::sort(first, last, [&](const sort_key& a, const sort_key& b) {
+                        return strings[a.index].view().substr(r.depth) < strings[b.index].view().substr(r.depth);
+                    });
+                    continue;
+                }
+                bool same = true;
+                for (sort_key* k = first; k != last; ++k) {
+                    strings[k->index].sort_prefix(*k, r.depth, per, bits);
+                    same = same && *k == *first;
+                }
+                // a prefix every string shares (a common directory, say) needs no sort
+                if (same) {
+                    if (first->low & last_field) pending.push_back({ r.first, r.last, r.depth + 2 * per });
+                    continue;
+                }
+                std::sort(first, last);
+                // a tie that ends inside the key is a run of equal strings
+                for (sort_key* i = first; i != last;) {
+                    sort_key* j = i + 1;
+                    while (j != last && *j == *i) ++j;
+                    if (j - i > 1 && (i->low & last_field) != 0) {
+                        pending.push_back({ (size_t)(i - keys.data()), (size_t)(j - keys.data()), r.depth + 2 * per });
+                    }
+                    i = j;
+                }
+            }
+
+            std::vector<size_t> order(n);
+            for (size_t i = 0; i < n; ++i) order[i] = keys[i].index;
+            return order;
+        }
+
+        template<typename Part>
+        static stdx::string join_parts(const std::vector<Part>& parts, string_view delimiter, const allocator_type& alloc) {
+            stdx::string result(alloc);
+            if (parts.empty()) return result;
+            utf::utf_info d = part_info(delimiter);
+            size_t total = d.code_points * (parts.size() - 1);
+            char32_t bits = d.bits;
+            for (const auto& part : parts) {
+                utf::utf_info info = part_info(part);
+                total += info.code_points;
+                bits |= info.bits;
+            }
+            result.make_room(total, detail::width_for(bits));
+            result.visit([&](auto* dst) {
+                dst = write_part(dst, parts[0]);
+                for (size_t i = 1; i < parts.size(); ++i) {
+                    dst = write_part(dst, delimiter);
+                    dst = write_part(dst, parts[i]);
+                }
+            });
+            result.set_length(total);
             return result;
         }
+
+        // Appends one concat() part, growing geometrically.
+        template<typename Part>
+        inline void append_part(const Part& part) {
+            if constexpr (std::is_same_v<Part, stdx::string> || std::is_same_v<Part, string_view>) {
+                append(string_view(part)); // handles views of this string
+            }
+            else {
+                utf::utf_info info = part_info(part);
+                make_room(m_size + info.code_points, detail::width_for(info.bits));
+                visit([&](auto* dst) { write_part(dst + m_size, part); });
+                set_length(m_size + info.code_points);
+            }
+        }
+    };
+
+    //============================
+    // Builder
+    //============================
+    // Accumulates text in one growing buffer. Reserving the final length
+    // (and width, if wider than Latin-1) up front makes the whole build a
+    // single allocation; take() hands the buffer over without copying.
+    class string_builder {
+    public:
+        string_builder() = default;
+        explicit string_builder(size_t capacity, unsigned width = 1) { reserve(capacity, width); }
+        explicit string_builder(const stdx::string::allocator_type& alloc) : m_str(alloc) {}
+
+        // width: 1, 2 or 4 bytes per code point, as in stdx::string::width().
+        inline void reserve(size_t capacity, unsigned width = 1) { m_str.make_room(capacity, width); }
+
+        inline size_t size() const { return m_str.size(); }
+        inline bool empty() const { return m_str.empty(); }
+        inline size_t capacity() const { return m_str.capacity(); }
+        inline void clear() { m_str.clear(); }
+
+        // Anything stdx::string::concat() accepts (a char is a Latin-1 code
+        // point), and numbers, written as stdx::string::append_number does.
+        template<typename Part>
+        inline string_builder& append(const Part& part) {
+            if constexpr (std::is_arithmetic_v<Part> && !detail::is_code_unit<Part>) {
+                static_assert(!std::is_same_v<Part, bool>, "append bool as text");
+                m_str.append_number(part);
+            }
+            else {
+                static_assert(detail::is_text_part<Part>, "string_builder parts are text, characters or numbers");
+                m_str.append_part(part);
+            }
+            return *this;
+        }
+
+        template<typename Part>
+        inline string_builder& operator<<(const Part& part) { return append(part); }
+
+        inline string_view view() const { return m_str.view(); }
+        inline stdx::string str() const { return stdx::string(m_str, m_str.get_allocator()); }
+
+        // Moves the result out, leaving the builder empty.
+        inline stdx::string take() { return std::move(m_str); }
+
+    private:
+        stdx::string m_str;
+    };
+
+    //============================
+    // Tokenizer
+    //============================
+    // Forward range of string_view fields, found one at a time as it is
+    // iterated, so stopping after the first few fields of a large input
+    // costs only those fields. Fields are separated by one code point, any
+    // code point of a set, or a whole substring. Views point into the
+    // original text, which must outlive the tokenizer; the delimiters are
+    // copied.
+    class tokenizer {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const string_view*;
+            using reference = const string_view&;
+
+            iterator() = default;
+
+            inline reference operator*() const { return m_token; }
+            inline pointer operator->() const { return &m_token; }
+
+            inline iterator& operator++() { advance(); return *this; }
+            inline iterator operator++(int) { iterator t = *this; advance(); return t; }
+
+            inline bool operator==(const iterator& rhs) const {
+                return m_owner == rhs.m_owner && (!m_owner || m_fields == rhs.m_fields);
+            }
+            inline bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+        private:
+            friend class tokenizer;
+
+            explicit iterator(const tokenizer* owner) : m_owner(owner) { advance(); }
+
+            const tokenizer* m_owner = nullptr;  // null once past the last field
+            string_view m_token;
+            size_t m_next = 0;                   // npos after the last field
+            size_t m_fields = 0;
+
+            inline void advance() {
+                const string_view& text = m_owner->m_text;
+                const split_options& opt = m_owner->m_options;
+                for (;;) {
+                    if (m_next == npos || (m_next == text.size() && !opt.keep_empty)) {
+                        m_owner = nullptr;
+                        return;
+                    }
+                    size_t start = m_next, len = 0;
+                    size_t hit = m_fields < opt.max_splits ? m_owner->find(start, len) : npos;
+                    if (hit == npos) {
+                        m_token = text.substr(start);
+                        m_next = npos;
+                    }
+                    else {
+                        m_token = text.substr(start, hit - start);
+                        m_next = hit + len;
+                    }
+                    if (opt.keep_empty || !m_token.empty()) {
+                        ++m_fields;
+                        return;
+                    }
+                }
+            }
+        };
+
+        using const_iterator = iterator;
+
+        tokenizer(string_view text, char32_t delimiter, split_options options = {})
+            : m_text(text), m_options(options), m_kind(kind::unit), m_unit(delimiter) {}
+
+        inline iterator begin() const { return iterator(this); }
+        inline iterator end() const { return iterator(); }
+
+        // Separator is a whole substring; an empty one never matches.
+        static tokenizer on(string_view text, string_view separator, split_options options = {}) {
+            tokenizer t(text, U'\0', options);
+            t.m_kind = kind::substring;
+            t.m_delims = stdx::string(separator);
+            return t;
+        }
+
+        // Any code point of delimiters separates fields.
+        static tokenizer any_of(string_view text, string_view delimiters, split_options options = {}) {
+            tokenizer t(text, U'\0', options);
+            t.m_kind = kind::any;
+            t.m_delims = stdx::string(delimiters);
+            for (char32_t c : delimiters) {
+                if (c < 256) t.m_latin1[c >> 5] |= 1u << (c & 31);
+                else t.m_wide = true;
+            }
+            return t;
+        }
+
+    private:
+        static constexpr size_t npos = (size_t)-1;
+        enum class kind : unsigned char { unit, any, substring };
+
+        string_view m_text;
+        split_options m_options;
+        kind m_kind;
+        char32_t m_unit;
+        stdx::string m_delims;
+        uint32_t m_latin1[8] = {}; // kind::any membership for code points < 256
+        bool m_wide = false;       // kind::any has code points >= 256
+
+        // Next delimiter at or after from, with its length in len.
+        inline size_t find(size_t from, size_t& len) const {
+            switch (m_kind) {
+            case kind::unit:
+                len = 1;
+                return m_text.index_of(m_unit, from);
+            case kind::any:
+                len = 1;
+                return m_text.visit([&](const auto* p) {
+                    for (size_t i = from; i < m_text.m_size; ++i) {
+                        char32_t c = p[i];
+                        if (c < 256 ? (m_latin1[c >> 5] >> (c & 31)) & 1 : m_wide && m_delims.contains(c)) return i;
+                    }
+                    return npos;
+                });
+            default:
+                len = m_delims.size();
+                return len ? m_text.index_of(m_delims.view(), from) : npos;
+            }
+        }
+    };
+
+    inline tokenizer string_view::tokenize(char32_t delimiter, split_options options) const {
+        return tokenizer(*this, delimiter, options);
+    }
+
+    inline tokenizer string_view::tokenize(string_view separator, split_options options) const {
+        return tokenizer::on(*this, separator, options);
+    }
+
+    inline tokenizer string_view::tokenize_any(string_view delimiters, split_options options) const {
+        return tokenizer::any_of(*this, delimiters, options);
+    }
+
+    inline tokenizer string::tokenize(char32_t delimiter, split_options options) const {
+        return view().tokenize(delimiter, options);
+    }
+
+    inline tokenizer string::tokenize(string_view separator, split_options options) const {
+        return view().tokenize(separator, options);
+    }
+
+    inline tokenizer string::tokenize_any(string_view delimiters, split_options options) const {
+        return view().tokenize_any(delimiters, options);
+    }
+
+    inline stdx::string string_view::to_string() const {
+        return stdx::string(*this);
+    }
+
+    //============================
+    // Literals
+    //============================
+    // "text"_sx is decoded from UTF-8 while compiling, into static storage
+    // at the narrowest width that holds it, and evaluates to a string_view
+    // of that storage. Members taking a string_view use it as it is, and a
+    // stdx::string built from one copies units without transcoding.
+    //
+    //     using namespace stdx::literals;
+    //     path.replace("/"_sx, "\\"_sx);
+    //
+    // Needs class-type template parameters (C++20), or GCC / Clang, whose
+    // string literal operator templates stand in for them in C++17.
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+#   define STDX_STRING_LITERALS 1
+#elif defined(__GNUC__)
+#   define STDX_STRING_LITERALS 1
+#   define STDX_STRING_LITERALS_GNU 1
+#endif
+
+#if defined(STDX_STRING_LITERALS)
+    namespace detail {
+        struct literal_info {
+            size_t size;   // code points
+            char32_t bits; // OR of all of them
+        };
+
+        constexpr literal_info measure_literal(const unsigned char* s, size_t n) {
+            literal_info info = { 0, 0 };
+            for (size_t i = 0; i < n; ++info.size) {
+                char32_t cp = s[i];
+                if (cp < 0x80) ++i;
+                else i += utf::detail::decode_sequence(s + i, s + n, cp);
+                info.bits |= cp;
+            }
+            return info;
+        }
+
+        template<typename Unit, size_t N>
+        struct literal_units {
+            Unit units[N + 1] = {};
+        };
+
+        template<typename Unit, size_t N>
+        constexpr literal_units<Unit, N> decode_literal(const unsigned char* s, size_t n) {
+            literal_units<Unit, N> out;
+            for (size_t i = 0, o = 0; i < n; ++o) {
+                char32_t cp = s[i];
+                if (cp < 0x80) ++i;
+                else i += utf::detail::decode_sequence(s + i, s + n, cp);
+                out.units[o] = (Unit)cp;
+            }
+            return out;
+        }
+
+        // Text supplies the UTF-8 as static data and size members; each
+        // literal gets its own instantiation, so one payload per literal.
+        template<typename Text>
+        struct literal {
+            static constexpr literal_info info = measure_literal(Text::data, Text::size);
+            using unit = std::conditional_t<width_for(info.bits) == 1, unsigned char,
+                         std::conditional_t<width_for(info.bits) == 2, char16_t, char32_t>>;
+            static constexpr literal_units<unit, info.size> payload = decode_literal<unit, info.size>(Text::data, Text::size);
+
+            static inline string_view view() { return string_view(payload.units, info.size); }
+        };
+
+#if defined(STDX_STRING_LITERALS_GNU)
+        template<char... Cs>
+        struct literal_chars {
+            static constexpr unsigned char data[] = { (unsigned char)Cs..., 0 };
+            static constexpr size_t size = sizeof...(Cs);
+        };
+#else
+        template<size_t N>
+        struct literal_text {
+            unsigned char data[N] = {};
+
+            constexpr literal_text(const char (&s)[N]) {
+                for (size_t i = 0; i < N; ++i) data[i] = (unsigned char)s[i];
+            }
+        };
+
+        template<literal_text S>
+        struct literal_chars {
+            static constexpr const unsigned char* data = S.data;
+            static constexpr size_t size = sizeof(S.data) - 1;
+        };
+#endif
+    }
+
+    inline namespace literals {
+#if defined(STDX_STRING_LITERALS_GNU)
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wpedantic"
+#   if defined(__clang__)
+#       pragma GCC diagnostic ignored "-Wgnu-string-literal-operator-template"
+#   endif
+        template<typename C, C... Cs>
+        inline string_view operator""_sx() {
+            static_assert(std::is_same_v<C, char>, "_sx takes narrow (UTF-8) literals");
+            return detail::literal<detail::literal_chars<Cs...>>::view();
+        }
+#   pragma GCC diagnostic pop
+#else
+        template<detail::literal_text S>
+        inline string_view operator""_sx() {
+            return detail::literal<detail::literal_chars<S>>::view();
+        }
+#endif
+    }
+#endif
+}
+
+namespace std {
+    template<>
+    struct hash<stdx::string> {
+        inline size_t operator()(const stdx::string& s) const { return s.hash(); }
+    };
+
+    template<>
+    struct hash<stdx::string_view> {
+        inline size_t operator()(stdx::string_view s) const { return s.hash(); }
     };
 }
\ No newline at end of file
@@ -0,0 +1,781 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+//============================
+// SIMD feature detection
+//============================
+#if defined(__AVX2__)
+#   define STDX_UTF_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define STDX_UTF_SSE2 1
+#endif
+
+#if defined(STDX_UTF_AVX2)
+#   include <immintrin.h>
+#elif defined(STDX_UTF_SSE2)
+#   include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace stdx {
+    namespace utf {
+        static constexpr char32_t replacement_char = 0xFFFD;
+
+        namespace detail {
+            inline unsigned ctz(uint32_t v) {
+#if defined(_MSC_VER)
+                unsigned long idx;
+                _BitScanForward(&idx, v);
+                return (unsigned)idx;
+#else
+                return (unsigned)__builtin_ctz(v);
+#endif
+            }
+
+            // Decodes the multi-byte sequence at p (p[0] >= 0x80) into cp and
+            // returns the number of bytes consumed. Ill-formed input yields a
+            // single U+FFFD per maximal subpart (Unicode 3.9, Table 3-7).
+            // constexpr so that string literals can be decoded at compile time.
+            constexpr size_t decode_sequence(const unsigned char* p, const unsigned char* end, char32_t& cp) {
+                unsigned char b0 = p[0];
+                unsigned char lo = 0x80, hi = 0xBF;
+                size_t need = 0;
+
+                if (b0 >= 0xC2 && b0 <= 0xDF) { need = 1; cp = b0 & 0x1F; }
+                else if (b0 >= 0xE0 && b0 <= 0xEF) {
+                    need = 2; cp = b0 & 0x0F;
+                    if (b0 == 0xE0) lo = 0xA0;
+                    else if (b0 == 0xED) hi = 0x9F; // no surrogates
+                }
+                else if (b0 >= 0xF0 && b0 <= 0xF4) {
+                    need = 3; cp = b0 & 0x07;
+                    if (b0 == 0xF0) lo = 0x90;
+                    else if (b0 == 0xF4) hi = 0x8F; // nothing above U+10FFFF
+                }
+                else { cp = replacement_char; return 1; }
+
+                size_t avail = (size_t)(end - p);
+                for (size_t i = 1; i <= need; ++i) {
+                    if (i >= avail) { cp = replacement_char; return i; }
+                    unsigned char b = p[i];
+                    if (b < lo || b > hi) { cp = replacement_char; return i; }
+                    lo = 0x80; hi = 0xBF;
+                    cp = (cp << 6) | (b & 0x3F);
+                }
+                return need + 1;
+            }
+
+            inline size_t utf8_units(uint32_t cp) {
+                return cp <= 0x7F ? 1 : cp <= 0x7FF ? 2 : (cp <= 0xFFFF || cp > 0x10FFFF) ? 3 : 4;
+            }
+
+            inline unsigned popcount(uint32_t v) {
+                v = v - ((v >> 1) & 0x55555555);
+                v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+                return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+            }
+
+            template<typename Unit>
+            inline void put_utf16(Unit*& o, uint32_t cp) {
+                if (cp <= 0xFFFF) {
+                    *o++ = (Unit)cp;
+                }
+                else if (cp <= 0x10FFFF) {
+                    cp -= 0x10000;
+                    *o++ = (Unit)(0xD800 + (cp >> 10));
+                    *o++ = (Unit)(0xDC00 + (cp & 0x3FF));
+                }
+                else {
+                    *o++ = (Unit)replacement_char;
+                }
+            }
+
+            inline void put_utf8(char*& o, uint32_t cp) {
+                if (cp <= 0x7F) {
+                    *o++ = (char)cp;
+                }
+                else if (cp <= 0x7FF) {
+                    *o++ = (char)(0xC0 | (cp >> 6));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                }
+                else if (cp <= 0xFFFF || cp > 0x10FFFF) {
+                    if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0xFFFF) cp = replacement_char;
+                    *o++ = (char)(0xE0 | (cp >> 12));
+                    *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                }
+                else {
+                    *o++ = (char)(0xF0 | (cp >> 18));
+                    *o++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+                    *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                }
+            }
+
+#if defined(STDX_UTF_SSE2)
+            // Widens 16 ASCII bytes into 16 units of the destination width.
+            template<typename Unit>
+            inline void store_ascii(__m128i v, Unit* o) {
+                __m128i zero = _mm_setzero_si128();
+                if constexpr (sizeof(Unit) == 1) {
+                    _mm_storeu_si128((__m128i*)o, v);
+                }
+                else if constexpr (sizeof(Unit) == 2) {
+                    _mm_storeu_si128((__m128i*)(o + 0), _mm_unpacklo_epi8(v, zero));
+                    _mm_storeu_si128((__m128i*)(o + 8), _mm_unpackhi_epi8(v, zero));
+                }
+                else {
+                    __m128i w0 = _mm_unpacklo_epi8(v, zero);
+                    __m128i w1 = _mm_unpackhi_epi8(v, zero);
+                    _mm_storeu_si128((__m128i*)(o + 0), _mm_unpacklo_epi16(w0, zero));
+                    _mm_storeu_si128((__m128i*)(o + 4), _mm_unpackhi_epi16(w0, zero));
+                    _mm_storeu_si128((__m128i*)(o + 8), _mm_unpacklo_epi16(w1, zero));
+                    _mm_storeu_si128((__m128i*)(o + 12), _mm_unpackhi_epi16(w1, zero));
+                }
+            }
+
+            // Sums four lanes that each hold a non-positive count.
+            inline size_t hsum_neg(__m128i v) {
+                v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+                v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+                return (size_t)(uint32_t)(-_mm_cvtsi128_si32(v));
+            }
+#endif
+
+#if defined(STDX_UTF_AVX2)
+            template<typename Unit>
+            inline void store_ascii(__m256i v, Unit* o) {
+                __m128i lo = _mm256_castsi256_si128(v);
+                __m128i hi = _mm256_extracti128_si256(v, 1);
+                if constexpr (sizeof(Unit) == 1) {
+                    _mm256_storeu_si256((__m256i*)o, v);
+                }
+                else if constexpr (sizeof(Unit) == 2) {
+                    _mm256_storeu_si256((__m256i*)(o + 0), _mm256_cvtepu8_epi16(lo));
+                    _mm256_storeu_si256((__m256i*)(o + 16), _mm256_cvtepu8_epi16(hi));
+                }
+                else {
+                    _mm256_storeu_si256((__m256i*)(o + 0), _mm256_cvtepu8_epi32(lo));
+                    _mm256_storeu_si256((__m256i*)(o + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+                    _mm256_storeu_si256((__m256i*)(o + 16), _mm256_cvtepu8_epi32(hi));
+                    _mm256_storeu_si256((__m256i*)(o + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+                }
+            }
+#endif
+        }
+
+        struct utf_info {
+            size_t code_points = 0;
+            char32_t bits = 0; // OR of the decoded code points, enough to pick a storage width
+        };
+
+        namespace detail {
+#if defined(STDX_UTF_AVX2)
+            // Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction
+            // Per Byte" (2021): three nibble lookups flag every bad pair of
+            // adjacent bytes, and a shifted compare finds the 3rd/4th bytes
+            // that must be continuations. Each flag bit names one error kind.
+            static constexpr char too_short = 1 << 0;  // lead not followed by a continuation
+            static constexpr char too_long = 1 << 1;   // ASCII followed by a continuation
+            static constexpr char overlong_3 = 1 << 2;
+            static constexpr char too_large = 1 << 3;
+            static constexpr char surrogate = 1 << 4;
+            static constexpr char overlong_2 = 1 << 5;
+            static constexpr char too_large_1000 = 1 << 6;
+            static constexpr char overlong_4 = 1 << 6;
+            static constexpr char two_conts = (char)(1 << 7);
+            static constexpr char carry = too_short | too_long | two_conts;
+
+            inline __m256i nibble_lookup(__m128i table, __m256i nibbles) {
+                return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(table), nibbles);
+            }
+
+            inline __m256i high_nibbles(__m256i v) {
+                return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+            }
+
+            // input shifted N bytes later, with prev's last bytes coming in
+            template<int N>
+            inline __m256i prev_bytes(__m256i input, __m256i prev) {
+                return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+            }
+
+            inline __m256i block_errors(__m256i input, __m256i prev) {
+                __m256i prev1 = prev_bytes<1>(input, prev);
+                __m256i byte1High = nibble_lookup(_mm_setr_epi8(
+                    too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                    two_conts, two_conts, two_conts, two_conts,
+                    too_short | overlong_2, too_short, too_short | overlong_3 | surrogate,
+                    too_short | too_large | too_large_1000 | overlong_4), high_nibbles(prev1));
+                __m256i byte1Low = nibble_lookup(_mm_setr_epi8(
+                    carry | overlong_3 | overlong_2 | overlong_4, carry | overlong_2, carry, carry,
+                    carry | too_large, carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000, carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000, carry | too_large | too_large_1000 | surrogate,
+                    carry | too_large | too_large_1000, carry | too_large | too_large_1000),
+                    _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+                __m256i byte2High = nibble_lookup(_mm_setr_epi8(
+                    too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                    too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+                    too_long | overlong_2 | two_conts | overlong_3 | too_large,
+                    too_long | overlong_2 | two_conts | surrogate | too_large,
+                    too_long | overlong_2 | two_conts | surrogate | too_large,
+                    too_short, too_short, too_short, too_short), high_nibbles(input));
+                __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+                // only bytes after a 111_____ two back or a 1111____ three back get 0x80
+                __m256i third = _mm256_subs_epu8(prev_bytes<2>(input, prev), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+                __m256i fourth = _mm256_subs_epu8(prev_bytes<3>(input, prev), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+                __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+                return _mm256_xor_si256(must23, special);
+            }
+
+            inline bool validate_utf8_avx2(const unsigned char* p, size_t n) {
+                const __m256i zero = _mm256_setzero_si256();
+                // non-zero where a block's last bytes start a sequence it cuts off
+                const __m256i maxTail = _mm256_setr_epi8(
+                    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                    (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+                __m256i error = zero, prev = zero, incomplete = zero;
+                unsigned char tail[32] = {};
+                for (size_t i = 0; i < n; i += 32) {
+                    __m256i input;
+                    if (n - i >= 32) input = _mm256_loadu_si256((const __m256i*)(p + i));
+                    else {
+                        memcpy(tail, p + i, n - i);
+                        input = _mm256_loadu_si256((const __m256i*)tail);
+                    }
+                    if (!_mm256_movemask_epi8(input)) {
+                        error = _mm256_or_si256(error, incomplete);
+                        incomplete = zero;
+                    }
+                    else {
+                        error = _mm256_or_si256(error, block_errors(input, prev));
+                        incomplete = _mm256_subs_epu8(input, maxTail);
+                    }
+                    prev = input;
+                }
+                error = _mm256_or_si256(error, incomplete);
+                return _mm256_testz_si256(error, error) != 0;
+            }
+
+            // Counts and sizes input already known to be valid: every byte but
+            // a continuation starts a code point, and the largest lead byte
+            // gives the storage width.
+            inline utf_info inspect_valid_utf8(const unsigned char* p, size_t n) {
+                const __m256i lastCont = _mm256_set1_epi8((char)0xBF);
+                __m256i top = _mm256_setzero_si256();
+                size_t count = 0, i = 0;
+                for (; i + 32 <= n; i += 32) {
+                    __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+                    count += popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, lastCont)));
+                    top = _mm256_max_epu8(top, v);
+                }
+                unsigned char lanes[32], maxByte = 0;
+                _mm256_storeu_si256((__m256i*)lanes, top);
+                for (unsigned char b : lanes) maxByte = b > maxByte ? b : maxByte;
+                for (; i < n; ++i) {
+                    count += (signed char)p[i] > (signed char)0xBF;
+                    maxByte = p[i] > maxByte ? p[i] : maxByte;
+                }
+                return { count, (char32_t)(maxByte >= 0xF0 ? 0x10000 : maxByte >= 0xC4 ? 0x100 : maxByte) };
+            }
+#endif
+        }
+
+        //============================
+        // UTF-8 validation
+        //============================
+        // True when n bytes are well-formed UTF-8 (no overlongs, surrogates,
+        // truncated sequences or values above U+10FFFF).
+        inline bool validate_utf8(const char* src, size_t n) {
+            const unsigned char* p = (const unsigned char*)src;
+#if defined(STDX_UTF_AVX2)
+            return detail::validate_utf8_avx2(p, n);
+#else
+            const unsigned char* end = p + n;
+            while (p < end) {
+                if (*p >= 0x80) {
+                    char32_t cp;
+                    size_t len = detail::decode_sequence(p, end, cp);
+                    // U+FFFD itself (EF BF BD) is the only way to decode it without an error
+                    if (cp == replacement_char && !(len == 3 && *p == 0xEF)) return false;
+                    p += len;
+                    continue;
+                }
+#if defined(STDX_UTF_SSE2)
+                while (end - p >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p))) p += 16;
+#endif
+                while (p < end && *p < 0x80) p++;
+            }
+            return true;
+#endif
+        }
+
+        //============================
+        // UTF-8 -> code points
+        //============================
+        // Counts the code points n bytes of UTF-8 decode to, so callers can
+        // size their buffer exactly before calling decode_utf8.
+        inline utf_info inspect_utf8(const char* src, size_t n) {
+            const unsigned char* p = (const unsigned char*)src;
+            const unsigned char* end = p + n;
+            utf_info info;
+#if defined(STDX_UTF_AVX2)
+            // well-formed text (the usual case) needs no decoding to be counted
+            if (detail::validate_utf8_avx2(p, n)) return detail::inspect_valid_utf8(p, n);
+#endif
+
+            while (p < end) {
+                if (*p >= 0x80) {
+                    char32_t cp;
+                    p += detail::decode_sequence(p, end, cp);
+                    info.bits |= cp;
+                    info.code_points++;
+                    continue;
+                }
+#if defined(STDX_UTF_SSE2)
+                while (end - p >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p))) {
+                    p += 16; info.code_points += 16;
+                }
+#endif
+                while (p < end && *p < 0x80) { p++; info.code_points++; }
+            }
+            return info;
+        }
+
+        // Code points decode_utf8 produces from n bytes.
+        inline size_t count_code_points(const char* src, size_t n) {
+            return inspect_utf8(src, n).code_points;
+        }
+
+        // Decodes n bytes of UTF-8 into out, which must hold
+        // inspect_utf8(src, n).code_points units wide enough for its bits.
+        // Returns the number of code points written.
+        template<typename Unit>
+        inline size_t decode_utf8(const char* src, size_t n, Unit* out) {
+            const unsigned char* p = (const unsigned char*)src;
+            const unsigned char* end = p + n;
+            Unit* o = out;
+
+            while (p < end) {
+                if (*p >= 0x80) {
+                    char32_t cp;
+                    p += detail::decode_sequence(p, end, cp);
+                    *o++ = (Unit)cp;
+                    continue;
+                }
+#if defined(STDX_UTF_AVX2)
+                while (end - p >= 32) {
+                    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+                    if (_mm256_movemask_epi8(v)) break;
+                    detail::store_ascii(v, o);
+                    p += 32; o += 32;
+                }
+#endif
+#if defined(STDX_UTF_SSE2)
+                while (end - p >= 16) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)p);
+                    if (_mm_movemask_epi8(v)) break;
+                    detail::store_ascii(v, o);
+                    p += 16; o += 16;
+                }
+#endif
+                while (p < end && *p < 0x80) *o++ = (Unit)*p++;
+            }
+            return (size_t)(o - out);
+        }
+
+        //============================
+        // UTF-16 -> code points
+        //============================
+        // Src is char16_t, or wchar_t where that is 16 bits wide. Valid
+        // surrogate pairs are combined; lone surrogates pass through.
+        template<typename Src>
+        inline utf_info inspect_utf16(const Src* src, size_t n) {
+            utf_info info;
+            info.code_points = n;
+            for (size_t i = 0; i < n; ++i) {
+                char32_t c = (char16_t)src[i];
+                info.bits |= c;
+                if (c >= 0xD800 && c <= 0xDBFF && i + 1 < n && (char16_t)src[i + 1] >= 0xDC00 && (char16_t)src[i + 1] <= 0xDFFF) {
+                    info.bits |= 0x10000;
+                    info.code_points--;
+                    ++i;
+                }
+            }
+            return info;
+        }
+
+        template<typename Unit, typename Src>
+        inline size_t decode_utf16(const Src* src, size_t n, Unit* out) {
+            Unit* o = out;
+            for (size_t i = 0; i < n; ++i) {
+                char32_t c = (char16_t)src[i];
+                if (c >= 0xD800 && c <= 0xDBFF && i + 1 < n) {
+                    char32_t c2 = (char16_t)src[i + 1];
+                    if (c2 >= 0xDC00 && c2 <= 0xDFFF) {
+                        *o++ = (Unit)(0x10000 + (((c - 0xD800) << 10) | (c2 - 0xDC00)));
+                        ++i;
+                        continue;
+                    }
+                }
+                *o++ = (Unit)c;
+            }
+            return (size_t)(o - out);
+        }
+
+        //============================
+        // Code points <-> encoded text, compared in place
+        //============================
+        // Compare n code points against UTF-8 / UTF-16 text decoded as they go
+        // (ill-formed input decodes exactly as in decode_utf8 / decode_utf16),
+        // stopping at the first difference. Nothing is allocated. The result
+        // orders by code point like std::u32string::compare.
+        template<typename Unit>
+        inline int compare_utf8(const Unit* p, size_t n, const char* src, size_t len) {
+            const unsigned char* q = (const unsigned char*)src;
+            const unsigned char* end = q + len;
+            size_t i = 0;
+
+            while (i < n && q < end) {
+#if defined(STDX_UTF_SSE2)
+                if constexpr (sizeof(Unit) == 1) {
+                    // equal ASCII runs go 16 at a time
+                    while (n - i >= 16 && end - q >= 16) {
+                        __m128i b = _mm_loadu_si128((const __m128i*)q);
+                        __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+                        if (_mm_movemask_epi8(b) || _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) break;
+                        i += 16; q += 16;
+                    }
+                    if (i == n || q == end) break;
+                }
+#endif
+                char32_t cp = *q;
+                if (cp < 0x80) ++q;
+                else q += detail::decode_sequence(q, end, cp);
+                char32_t c = (char32_t)p[i++];
+                if (c != cp) return c < cp ? -1 : 1;
+            }
+            return i < n ? 1 : q < end ? -1 : 0;
+        }
+
+        // Src is char16_t, or wchar_t where that is 16 bits wide.
+        template<typename Unit, typename Src>
+        inline int compare_utf16(const Unit* p, size_t n, const Src* src, size_t len) {
+            size_t i = 0, j = 0;
+            while (i < n && j < len) {
+                char32_t cp = (char16_t)src[j++];
+                if (cp >= 0xD800 && cp <= 0xDBFF && j < len) {
+                    char32_t c2 = (char16_t)src[j];
+                    if (c2 >= 0xDC00 && c2 <= 0xDFFF) {
+                        cp = 0x10000 + (((cp - 0xD800) << 10) | (c2 - 0xDC00));
+                        ++j;
+                    }
+                }
+                char32_t c = (char32_t)p[i++];
+                if (c != cp) return c < cp ? -1 : 1;
+            }
+            return i < n ? 1 : j < len ? -1 : 0;
+        }
+
+        //============================
+        // Code points -> UTF-8 / UTF-16
+        //============================
+        // Sources are code point arrays in one of the three stdx::string
+        // storage widths: Latin-1 bytes, UCS-2 units or UTF-32.
+        //
+        // Surrogates and values above U+10FFFF cannot be encoded as UTF-8 and
+        // come out as U+FFFD. UTF-16 passes lone surrogates through so that a
+        // wstring -> stdx::string -> wstring round trip is lossless.
+        inline size_t utf8_length_of(const unsigned char* s, size_t n) {
+            size_t len = n, i = 0;
+#if defined(STDX_UTF_SSE2)
+            for (; i + 16 <= n; i += 16) {
+                len += detail::popcount((uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(s + i))));
+            }
+#endif
+            for (; i < n; ++i) len += s[i] >> 7;
+            return len;
+        }
+
+        inline size_t utf8_length_of(const char16_t* s, size_t n) {
+            size_t len = n, i = 0;
+#if defined(STDX_UTF_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i lim1 = _mm_set1_epi16(0x7F);
+            const __m128i lim2 = _mm_set1_epi16(0x7FF);
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                // saturating subtract leaves a non-zero lane only above the limit
+                uint32_t le1 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_subs_epu16(v, lim1), zero));
+                uint32_t le2 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_subs_epu16(v, lim2), zero));
+                len += (detail::popcount(~le1 & 0xFFFF) + detail::popcount(~le2 & 0xFFFF)) / 2;
+            }
+#endif
+            for (; i < n; ++i) len += (s[i] > 0x7F) + (s[i] > 0x7FF);
+            return len;
+        }
+
+        inline size_t utf8_length_of(const char32_t* s, size_t n) {
+            size_t len = 0, i = 0;
+#if defined(STDX_UTF_SSE2)
+            const __m128i hiMask = _mm_set1_epi32((int)0xFFFF0000);
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i lim1 = _mm_set1_epi32(0x7F);
+            const __m128i lim2 = _mm_set1_epi32(0x7FF);
+            // lanes count extra bytes downwards from zero; flush before they can wrap
+            __m128i acc = zero;
+            size_t blocks = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, hiMask), zero)) != 0xFFFF) {
+                    for (size_t k = 0; k < 4; ++k) len += detail::utf8_units(s[i + k]);
+                    continue;
+                }
+                acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_cmpgt_epi32(v, lim1), _mm_cmpgt_epi32(v, lim2)));
+                len += 4;
+                if (++blocks == ((size_t)1 << 26)) {
+                    len += detail::hsum_neg(acc);
+                    acc = zero;
+                    blocks = 0;
+                }
+            }
+            len += detail::hsum_neg(acc);
+#endif
+            for (; i < n; ++i) len += detail::utf8_units(s[i]);
+            return len;
+        }
+
+        // Encodes n code points into out, which must hold utf8_length_of(s, n)
+        // bytes. Returns the number of bytes written.
+        inline size_t encode_utf8(const unsigned char* s, size_t n, char* out) {
+            char* o = out;
+            size_t i = 0;
+            while (i < n) {
+#if defined(STDX_UTF_SSE2)
+                while (i + 16 <= n) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                    if (_mm_movemask_epi8(v)) break;
+                    _mm_storeu_si128((__m128i*)o, v);
+                    i += 16; o += 16;
+                }
+#endif
+                size_t stop = i + 16 < n ? i + 16 : n;
+                for (; i < stop; ++i) detail::put_utf8(o, s[i]);
+            }
+            return (size_t)(o - out);
+        }
+
+        inline size_t encode_utf8(const char16_t* s, size_t n, char* out) {
+            char* o = out;
+            size_t i = 0;
+            while (i < n) {
+#if defined(STDX_UTF_SSE2)
+                const __m128i nonAscii = _mm_set1_epi16((short)0xFF80);
+                while (i + 8 <= n) {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, nonAscii), _mm_setzero_si128())) != 0xFFFF) break;
+                    _mm_storel_epi64((__m128i*)o, _mm_packus_epi16(v, v));
+                    i += 8; o += 8;
+                }
+#endif
+                size_t stop = i + 8 < n ? i + 8 : n;
+                for (; i < stop; ++i) detail::put_utf8(o, s[i]);
+            }
+            return (size_t)(o - out);
+        }
+
+        inline size_t encode_utf8(const char32_t* s, size_t n, char* out) {
+            char* o = out;
+            size_t i = 0;
+            while (i < n) {
+#if defined(STDX_UTF_SSE2)
+                const __m128i nonAscii = _mm_set1_epi32((int)0xFFFFFF80);
+                while (i + 16 <= n) {
+                    __m128i a = _mm_loadu_si128((const __m128i*)(s + i + 0));
+                    __m128i b = _mm_loadu_si128((const __m128i*)(s + i + 4));
+                    __m128i c = _mm_loadu_si128((const __m128i*)(s + i + 8));
+                    __m128i d = _mm_loadu_si128((const __m128i*)(s + i + 12));
+                    __m128i any = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), nonAscii);
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi32(any, _mm_setzero_si128())) != 0xFFFF) break;
+                    __m128i narrow = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                    _mm_storeu_si128((__m128i*)o, narrow);
+                    i += 16; o += 16;
+                }
+#endif
+                size_t stop = i + 16 < n ? i + 16 : n;
+                for (; i < stop; ++i) detail::put_utf8(o, s[i]);
+            }
+            return (size_t)(o - out);
+        }
+
+        inline size_t utf16_length_of(const unsigned char*, size_t n) { return n; }
+        inline size_t utf16_length_of(const char16_t*, size_t n) { return n; }
+
+        inline size_t utf16_length_of(const char32_t* s, size_t n) {
+            size_t len = n, i = 0;
+#if defined(STDX_UTF_SSE2)
+            const __m128i hiMask = _mm_set1_epi32((int)0xFFFF0000);
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 4 <= n; i += 4) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, hiMask), zero)) != 0xFFFF) {
+                    for (size_t k = 0; k < 4; ++k) len += (s[i + k] > 0xFFFF && s[i + k] <= 0x10FFFF);
+                }
+            }
+#endif
+            for (; i < n; ++i) len += (s[i] > 0xFFFF && s[i] <= 0x10FFFF);
+            return len;
+        }
+
+        // Encodes n code points into out, which must hold utf16_length_of(s, n)
+        // units. Unit is char16_t, or wchar_t where that is 16 bits wide.
+        template<typename Unit>
+        inline size_t encode_utf16(const unsigned char* s, size_t n, Unit* out) {
+            static_assert(sizeof(Unit) == 2, "encode_utf16 needs a 16-bit code unit");
+            size_t i = 0;
+#if defined(STDX_UTF_SSE2)
+            for (; i + 16 <= n; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+                _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(v, _mm_setzero_si128()));
+            }
+#endif
+            for (; i < n; ++i) out[i] = (Unit)s[i];
+            return n;
+        }
+
+        template<typename Unit>
+        inline size_t encode_utf16(const char16_t* s, size_t n, Unit* out) {
+            static_assert(sizeof(Unit) == 2, "encode_utf16 needs a 16-bit code unit");
+            if (n) memcpy(out, s, n * 2);
+            return n;
+        }
+
+        template<typename Unit>
+        inline size_t encode_utf16(const char32_t* s, size_t n, Unit* out) {
+            static_assert(sizeof(Unit) == 2, "encode_utf16 needs a 16-bit code unit");
+            Unit* o = out;
+            size_t i = 0;
+            while (i < n) {
+#if defined(STDX_UTF_SSE2)
+                const __m128i hiMask = _mm_set1_epi32((int)0xFFFF0000);
+                const __m128i bias32 = _mm_set1_epi32(0x8000);
+                const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+                while (i + 8 <= n) {
+                    __m128i a = _mm_loadu_si128((const __m128i*)(s + i + 0));
+                    __m128i b = _mm_loadu_si128((const __m128i*)(s + i + 4));
+                    __m128i any = _mm_and_si128(_mm_or_si128(a, b), hiMask);
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi32(any, _mm_setzero_si128())) != 0xFFFF) break;
+                    // SSE2 only has a signed 32->16 pack, so bias into its range and back
+                    __m128i narrow = _mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32));
+                    _mm_storeu_si128((__m128i*)o, _mm_add_epi16(narrow, bias16));
+                    i += 8; o += 8;
+                }
+#endif
+                size_t stop = i + 8 < n ? i + 8 : n;
+                for (; i < stop; ++i) detail::put_utf16(o, s[i]);
+            }
+            return (size_t)(o - out);
+        }
+
+        //============================
+        // Parallel transcoding
+        //============================
+        // Conversions of at least threshold bytes (or code points) are cut
+        // into one chunk per thread: every chunk is measured concurrently,
+        // the output is sized once from the totals, and every chunk is then
+        // converted concurrently into its own slice of it.
+        //
+        // The fields are plain, read by every conversion without a lock:
+        // configure them before any thread converts, never while one might.
+        struct parallel_options {
+            size_t threshold = (size_t)8 << 20;
+            unsigned threads = 0; // 0: std::thread::hardware_concurrency()
+            // Runs task(0) .. task(count - 1) and returns once all are done;
+            // set it to hand the chunks to an existing thread pool, which is
+            // the intended setup in production. Empty: chunk 0 runs on the
+            // calling thread and the others on std::threads started for this
+            // one conversion, which suits tools and tests.
+            std::function<void(size_t count, const std::function<void(size_t)>& task)> runner;
+        };
+
+        // Process-wide settings; configure before any thread converts.
+        inline parallel_options& parallel() {
+            static parallel_options options;
+            return options;
+        }
+
+        // Chunks a conversion of n units is split into; 1 keeps it serial.
+        inline size_t parallel_chunks(size_t n) {
+            const parallel_options& o = parallel();
+            if (n < o.threshold) return 1;
+            size_t threads = o.threads ? o.threads : std::max(1u, std::thread::hardware_concurrency());
+            return std::max<size_t>(1, std::min<size_t>(threads, n / (64 * 1024)));
+        }
+
+        template<typename F>
+        inline void parallel_for(size_t count, F&& task) {
+            if (count == 1) { task(0); return; }
+            const parallel_options& o = parallel();
+            if (o.runner) {
+                o.runner(count, std::function<void(size_t)>(std::ref(task)));
+                return;
+            }
+            // a chunk that throws must not unwind past running threads (or out
+            // of one), so failures are held until every worker is joined
+            std::vector<std::exception_ptr> errors(count);
+            auto run = [&](size_t i) {
+                try { task(i); }
+                catch (...) { errors[i] = std::current_exception(); }
+            };
+            std::vector<std::thread> workers;
+            workers.reserve(count - 1);
+            size_t spawned = 1;
+            try {
+                for (; spawned < count; ++spawned) workers.emplace_back([&run, spawned] { run(spawned); });
+            }
+            catch (const std::system_error&) {}
+            // whatever did not get a thread runs here
+            for (size_t i = spawned; i < count; ++i) run(i);
+            run(0);
+            for (std::thread& w : workers) w.join();
+            for (const std::exception_ptr& e : errors) {
+                if (e) std::rethrow_exception(e);
+            }
+        }
+
+        // Cuts n bytes of UTF-8 into chunks of about equal size, returning
+        // the chunks + 1 offsets that bound them. Cuts land on bytes that are
+        // not continuation bytes, where decode_utf8 starts a new sequence
+        // anyway, so the chunks decode to exactly the code points (and
+        // U+FFFDs) the whole input does.
+        inline std::vector<size_t> split_utf8(const char* src, size_t n, size_t chunks) {
+            std::vector<size_t> bounds(chunks + 1, n);
+            bounds[0] = 0;
+            for (size_t i = 1; i < chunks; ++i) {
+                size_t b = std::max(bounds[i - 1], n / chunks * i);
+                while (b < n && ((unsigned char)src[b] & 0xC0) == 0x80) ++b;
+                bounds[i] = b;
+            }
+            return bounds;
+        }
+    }
+}
\ No newline at end of file
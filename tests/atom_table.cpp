@@ -0,0 +1,111 @@
+// atom_table hands out one atom per distinct text: threads interning the
+// same keys at once, while the table grows from 64 slots to thousands,
+// must all get the same atom, and find() must return it from then on.
+// An atom's hash() is its text's stdx::string::hash(), whatever width the
+// key was stored at, and keys need not be Latin-1.
+//
+//   g++ -std=c++17 -O2 -pthread -I.. atom_table.cpp -o atom_table
+//   g++ -std=c++17 -O1 -g -pthread -fsanitize=thread -I.. atom_table.cpp -o atom_table
+//   cl /std:c++17 /O2 /EHsc /I.. atom_table.cpp
+//
+// Exits non-zero and names the first key that came back wrong.
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "../stdxatom.h"
+
+static std::atomic<int> failures{ 0 };
+static std::atomic<size_t> checked{ 0 };
+
+static void expect(bool ok, const char* what, const std::u32string& key) {
+    checked.fetch_add(1, std::memory_order_relaxed);
+    if (ok || failures.fetch_add(1) >= 10) return;
+    printf("FAIL %s: \"%s\"\n", what, std::string(stdx::string(key)).c_str());
+}
+
+// Latin-1, UCS-2 (Greek, CJK) and astral keys, some differing only in
+// their widest code point.
+static std::vector<std::u32string> make_keys(size_t n) {
+    static const char32_t marks[] = { U'k', 0xE9, 0x3B1, 0x4E2D, 0x1F600, 0x10FFFF };
+    std::vector<std::u32string> keys;
+    for (size_t i = 0; i < n; ++i) {
+        std::u32string k(1, marks[i % std::size(marks)]);
+        for (size_t v = i; v; v /= 10) k += char32_t(U'0' + v % 10);
+        keys.push_back(k);
+    }
+    return keys;
+}
+
+int main() {
+    const size_t key_count = 6000;
+    const unsigned thread_count = 8;
+    std::vector<std::u32string> keys = make_keys(key_count);
+
+    // every thread interns every key, in its own order, and looks back at
+    // keys it has already interned while the others grow the table
+    stdx::atom_table table;
+    std::vector<std::vector<stdx::atom>> got(thread_count, std::vector<stdx::atom>(key_count));
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<size_t> order(key_count);
+            for (size_t i = 0; i < key_count; ++i) order[i] = i;
+            std::mt19937 rng(t);
+            std::shuffle(order.begin(), order.end(), rng);
+            for (size_t n = 0; n < key_count; ++n) {
+                size_t i = order[n];
+                // half through a view, half through an owning string
+                stdx::string s(keys[i]);
+                got[t][i] = (i + t) % 2 ? table.intern(s) : table.intern(s.view());
+                size_t back = order[rng() % (n + 1)];
+                expect(table.find(stdx::string(keys[back])) == got[t][back], "find() during growth", keys[back]);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    expect(table.size() == key_count, "table size", U"");
+    std::unordered_set<stdx::atom> distinct;
+    for (size_t i = 0; i < key_count; ++i) {
+        const std::u32string& key = keys[i];
+        stdx::string s(key);
+        stdx::atom a = got[0][i];
+        bool same = true;
+        for (unsigned t = 1; t < thread_count; ++t) same = same && got[t][i] == a;
+        expect(same, "threads got different atoms", key);
+        expect(table.find(s) == a && table.find(s.view()) == a, "find() after the fact", key);
+        expect(a.view() == s.view() && a.size() == key.size() && a.str() == s, "atom text", key);
+        expect(a.hash() == s.hash() && std::hash<stdx::atom>()(a) == s.hash(), "hash() is stdx::string::hash()", key);
+        distinct.insert(a);
+    }
+    expect(distinct.size() == key_count, "distinct keys share an atom", U"");
+
+    // the same text stored wider than it needs is the same key
+    {
+        std::u32string key = keys[0];
+        stdx::string wide(key);
+        wide.append(stdx::string(U"\U0001F600"));
+        wide.remove(wide.size() - 1, 1);
+        expect(table.intern(wide) == got[0][0] && table.size() == key_count, "widened key interns to the same atom", key);
+        stdx::string text(U"α");
+        std::u16string ucs2(1, u'α');
+        expect(table.intern(text) == table.intern(stdx::string_view(ucs2.data(), 1)), "UCS-2 view interns to the same atom", U"α");
+    }
+
+    // absent keys and the empty string
+    expect(table.find(stdx::string(U"absent \U0001F600")).empty(), "find() of an absent key", U"absent");
+    stdx::atom empty = table.intern(stdx::string());
+    expect(empty == stdx::atom() && empty.empty() && empty.hash() == stdx::string().hash(), "empty atom", U"");
+
+    // the process-wide table
+    stdx::atom g = stdx::intern(stdx::string(U"中文"));
+    expect(g == stdx::intern(stdx::string_view(U"中文", 2)) && g != stdx::intern(stdx::string(U"中")), "stdx::intern", U"中文");
+
+    if (!failures) printf("ok   %zu atom checks, %zu keys, %u threads\n", checked.load(), key_count, thread_count);
+    return failures ? 1 : 0;
+}
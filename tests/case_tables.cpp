@@ -0,0 +1,101 @@
+// The two-stage case tables in stdxcase.h are generated data. This checks
+// every code point against the range lists they were built from, and with
+// --emit prints the tables again for pasting over the old ones after the
+// ranges change.
+//
+//   g++ -std=c++17 -I.. case_tables.cpp -o case_tables
+//   cl /std:c++17 /EHsc /I.. case_tables.cpp
+//
+// Exits non-zero and names the first mismatching code points.
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../stdxcase.h"
+
+using namespace stdx::unicode;
+using detail::case_range;
+using detail::case_record;
+
+template<size_t N>
+static int32_t delta_in(const case_range (&r)[N], char32_t c) {
+    for (const case_range& e : r)
+        if (c >= e.first && c <= e.last) return (c - e.first) % e.stride == 0 ? e.delta : 0;
+    return 0;
+}
+
+static case_record expected(char32_t c) {
+    return { delta_in(detail::upper_ranges, c), delta_in(detail::lower_ranges, c), delta_in(detail::fold_ranges, c) };
+}
+
+static bool same(const case_record& a, const case_record& b) {
+    return a.upper == b.upper && a.lower == b.lower && a.fold == b.fold;
+}
+
+// Rebuilds the tables: record 0 is the identity and block 0 maps nothing;
+// equal records and equal blocks are stored once, in first-use order.
+static void emit() {
+    const size_t block_size = detail::block_size;
+    std::vector<case_record> records{ { 0, 0, 0 } };
+    std::vector<std::vector<unsigned char>> blocks{ std::vector<unsigned char>(block_size) };
+    std::vector<unsigned char> stage1(detail::stage1_size);
+
+    for (size_t b = 0; b < stage1.size(); ++b) {
+        std::vector<unsigned char> block(block_size);
+        for (size_t i = 0; i < block_size; ++i) {
+            case_record rec = expected((char32_t)(b * block_size + i));
+            size_t r = 0;
+            while (r < records.size() && !same(records[r], rec)) ++r;
+            if (r == records.size()) records.push_back(rec);
+            block[i] = (unsigned char)r;
+        }
+        size_t k = 0;
+        while (k < blocks.size() && blocks[k] != block) ++k;
+        if (k == blocks.size()) blocks.push_back(block);
+        stage1[b] = (unsigned char)k;
+    }
+
+    printf("            static constexpr unsigned char stage1[stage1_size] = {\n");
+    for (size_t i = 0; i < stage1.size(); i += 32) {
+        printf("               ");
+        for (size_t j = i; j < stage1.size() && j < i + 32; ++j) printf(" %u,", stage1[j]);
+        printf("\n");
+    }
+    printf("            };\n\n");
+
+    printf("            static constexpr unsigned char stage2[][block_size] = {\n");
+    for (const auto& block : blocks) {
+        for (size_t i = 0; i < block_size; i += 32) {
+            printf(i ? "                 " : "                {");
+            for (size_t j = i; j < i + 32; ++j) printf(" %u,", block[j]);
+            printf(i + 32 == block_size ? " },\n" : "\n");
+        }
+    }
+    printf("            };\n\n");
+
+    printf("            static constexpr case_record records[] = {\n");
+    for (size_t i = 0; i < records.size(); i += 4) {
+        printf("               ");
+        for (size_t j = i; j < records.size() && j < i + 4; ++j) printf(" { %d, %d, %d },", records[j].upper, records[j].lower, records[j].fold);
+        printf("\n");
+    }
+    printf("            };\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && !strcmp(argv[1], "--emit")) {
+        emit();
+        return 0;
+    }
+
+    size_t failures = 0;
+    for (char32_t c = 0; c <= 0x10FFFF; ++c) {
+        case_record want = expected(c);
+        case_record got = { (int32_t)(to_upper(c) - c), (int32_t)(to_lower(c) - c), (int32_t)(fold(c) - c) };
+        if (!same(want, got) && failures++ < 10)
+            printf("FAIL U+%04X: upper %+d lower %+d fold %+d, expected %+d %+d %+d\n", (unsigned)c,
+                got.upper, got.lower, got.fold, want.upper, want.lower, want.fold);
+    }
+    if (failures) printf("%zu code points differ; rebuild the tables with --emit\n", failures);
+    else printf("ok   all code points match the range lists\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+// Print's format specs ([[fill]align][sign][#][0][width][.precision][type])
+// must produce exactly these strings, under C++17 (specs parsed at the
+// call) and C++20 (parsed at compile time), and with floating-point values
+// written by std::to_chars or by the snprintf fallback. Build all four:
+//
+//   g++ -std=c++17 -I.. format_specs.cpp -o format_specs
+//   g++ -std=c++20 -I.. format_specs.cpp -o format_specs
+//   g++ -std=c++17 -DSTDX_NO_FLOAT_TO_CHARS -I.. format_specs.cpp -o format_specs
+//   g++ -std=c++20 -DSTDX_NO_FLOAT_TO_CHARS -I.. format_specs.cpp -o format_specs
+//   cl /std:c++17 /EHsc /I.. format_specs.cpp
+//   cl /std:c++20 /EHsc /I.. format_specs.cpp
+//
+// Exits non-zero and names the failing spec on a mismatch.
+#include <cstdio>
+#include <limits>
+#include <string>
+#ifndef _WIN32
+#include <unistd.h>
+static int _write(int fd, const void* p, unsigned int n) { return (int)write(fd, p, n); }
+#endif
+#include "../stdxout.h"
+
+static int failures = 0, checked = 0;
+
+// Formats as Print would, through the same format_string parameter.
+template<typename... Args>
+static std::string format(stdx::format_string<Args...> message, Args&&... args) {
+    stdx::detail::format_buffer out;
+    stdx::detail::format_to(out, message, args...);
+    return std::string(out.data(), out.size());
+}
+
+static void expect(const char* name, const std::string& got, const std::string& want) {
+    ++checked;
+    if (got == want) return;
+    printf("FAIL %s: \"%s\", expected \"%s\"\n", name, got.c_str(), want.c_str());
+    ++failures;
+}
+
+int main() {
+    // integers: bases, prefixes, sign and zero padding
+    expect("{:x}", format("{:x}", 255), "ff");
+    expect("{:X}", format("{:X}", 255), "FF");
+    expect("{:#x}", format("{:#x}", 255), "0xff");
+    expect("{:#X}", format("{:#X}", 255), "0XFF");
+    expect("{:#x} negative", format("{:#x}", -255), "-0xff");
+    expect("{:#o}", format("{:#o}", 8), "010");
+    expect("{:#o} zero", format("{:#o}", 0), "0");
+    expect("{:#b}", format("{:#b}", 5), "0b101");
+    expect("{:o} unsigned", format("{:o}", 8u), "10");
+    expect("{:08}", format("{:08}", 42), "00000042");
+    expect("{:08} negative", format("{:08}", -42), "-0000042");
+    expect("{:#010x}", format("{:#010x}", 255), "0x000000ff");
+    expect("{:+}", format("{:+}", 5), "+5");
+    expect("{:+} negative", format("{:+}", -5), "-5");
+    expect("{: }", format("{: }", 5), " 5");
+    expect("{:5}", format("{:5}", 42), "   42");
+    expect("{:<5}", format("{:<5}", 42), "42   ");
+    expect("{:*^9} integer", format("{:*^9}", 42), "***42****");
+    expect("{:<08} ignores 0", format("{:<08}", 42), "42      ");
+    expect("{:d} int64 min", format("{:d}", std::numeric_limits<long long>::min()), "-9223372036854775808");
+    expect("{:x} uint64 max", format("{:x}", std::numeric_limits<unsigned long long>::max()), "ffffffffffffffff");
+
+    // characters and bool
+    expect("{} char", format("{}", 'A'), "A");
+    expect("{:d} char", format("{:d}", 'A'), "65");
+    expect("{:c} int", format("{:c}", 65), "A");
+    expect("{:>3} char", format("{:>3}", 'A'), "  A");
+    expect("{} bool", format("{}", true), "1");
+    expect("{:s} bool", format("{:s}", true), "true");
+    expect("{:>6s} bool", format("{:>6s}", false), " false");
+    expect("{:x} bool", format("{:x}", true), "1");
+
+    // text: width and precision count code points, fill is one code point
+    expect("{:>10}", format("{:>10}", "abc"), "       abc");
+    expect("{:*^9}", format("{:*^9}", "abc"), "***abc***");
+    expect("{:5} text", format("{:5}", "ab"), "ab   ");
+    expect("{:.2}", format("{:.2}", "abc"), "ab");
+    expect("{:6} UTF-8", format("{:6}", "caf\xC3\xA9"), "caf\xC3\xA9  ");
+    expect("{:.4} UTF-8", format("{:.4}", "caf\xC3\xA9!"), "caf\xC3\xA9");
+    expect("{:.3} UTF-8", format("{:.3}", "\xE2\x82\xAC\xF0\x9F\x98\x80xy"), "\xE2\x82\xAC\xF0\x9F\x98\x80x");
+    expect("{:\xC3\xA9^7}", format("{:\xC3\xA9^7}", "ab"), "\xC3\xA9\xC3\xA9" "ab" "\xC3\xA9\xC3\xA9\xC3\xA9");
+    expect("{:>5.2} std::string", format("{:>5.2}", std::string("hello")), "   he");
+    expect("{:>600} grows the buffer", format("{:>600}", "x"), std::string(599, ' ') + "x");
+
+    // floating point, through to_chars or the snprintf fallback
+    expect("{} double", format("{}", 0.1), "0.1");
+    expect("{} large double", format("{}", 1e20), "1e+20");
+    expect("{} float", format("{}", 0.1f), "0.1");
+    expect("{:.3f}", format("{:.3f}", 3.14159), "3.142");
+    expect("{:f}", format("{:f}", 1.5), "1.500000");
+    expect("{:+.1f}", format("{:+.1f}", 1.25), "+1.2");
+    expect("{:08.2f}", format("{:08.2f}", -3.14159), "-0003.14");
+    expect("{:e}", format("{:e}", 1234.5), "1.234500e+03");
+    expect("{:.2E}", format("{:.2E}", 1234.5), "1.23E+03");
+    expect("{:g}", format("{:g}", 0.0001), "0.0001");
+    expect("{:.3g}", format("{:.3g}", 1234.5), "1.23e+03");
+    expect("{:a}", format("{:a}", 1.0), "1p+0");
+    expect("{:A}", format("{:A}", -0.5), "-1P-1");
+    expect("{:.2a}", format("{:.2a}", 1.0), "1.00p+0");
+    expect("{:>8}", format("{:>8}", 2.5), "     2.5");
+    expect("{:08} inf", format("{:08}", std::numeric_limits<double>::infinity()), "     inf");
+    expect("{:F} -inf", format("{:F}", -std::numeric_limits<double>::infinity()), "-INF");
+    expect("{:.3g} long double", format("{:.3g}", 1.5L), "1.5");
+    expect("{:.1f} long double", format("{:.1f}", 2.25L), "2.2");
+    expect("{:e} long double", format("{:e}", 1234.5L), "1.234500e+03");
+
+    // a malformed spec formats the value as if there were none; C++20
+    // rejects one written in the message at compile time
+    expect("runtime {:q}", format(stdx::runtime_format("{:q}|{:>4}"), 5, 6), "5|   6");
+    expect("runtime {:5.}", format(stdx::runtime_format("[{:5.}]"), 5), "[5]");
+    expect("std::string {:#z}", format(std::string("<{:#z}>"), 255), "<255>");
+#if !CPP_AT_LEAST(CPP20)
+    expect("{:q}", format("{:q}", 5), "5");
+    expect("{:5x5}", format("[{:5x5}]", 255), "[255]");
+#endif
+
+    // replace_first_brace takes the same specs
+    std::string s = "n={:#06x}!";
+    stdx::replace_first_brace(s, 42);
+    expect("replace_first_brace", s, "n=0x002a!");
+
+#if defined(STDX_FLOAT_TO_CHARS)
+    const char* floats = "std::to_chars";
+#else
+    const char* floats = "snprintf";
+#endif
+    if (!failures) printf("ok   %d specs, C++%ld, floats by %s\n", checked, (long)(CPP_STD / 100 % 100), floats);
+    return failures ? 1 : 0;
+}
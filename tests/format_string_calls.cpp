@@ -0,0 +1,80 @@
+// The ways of passing Print a message that compiled before format strings
+// were parsed up front must still compile and print the same text, under
+// C++17 and C++20, with one exception: under C++20 a message with
+// arguments must be a constant expression, so a run-time const char* or
+// std::string_view with arguments needs runtime_format() there (that call
+// is checked as it is under C++17 only). Messages held in std::string,
+// stdx::string or stdx::string_view are taken at run time in both.
+//
+//   g++ -std=c++17 -I.. format_string_calls.cpp -o format_string_calls
+//   g++ -std=c++20 -I.. format_string_calls.cpp -o format_string_calls
+//   cl /std:c++17 /EHsc /I.. format_string_calls.cpp
+//   cl /std:c++20 /EHsc /I.. format_string_calls.cpp
+//
+// Exits non-zero and names the failing call on a mismatch.
+#include <cstdio>
+#include <string>
+#ifndef _WIN32
+#include <unistd.h>
+static int _write(int fd, const void* p, unsigned int n) { return (int)write(fd, p, n); }
+#endif
+#include "../stdxstring.h"
+#include "../stdxout.h"
+
+static int failures = 0;
+
+// Formats as Print would, through the same format_string parameter.
+template<typename... Args>
+static std::string format(stdx::format_string<Args...> message, Args&&... args) {
+    stdx::detail::format_buffer out;
+    stdx::detail::format_to(out, message, args...);
+    return std::string(out.data(), out.size());
+}
+
+static void expect(const char* name, const std::string& got, const char* want) {
+    if (got == want) {
+        printf("ok   %s\n", name);
+    }
+    else {
+        printf("FAIL %s: \"%s\", expected \"%s\"\n", name, got.c_str(), want);
+        ++failures;
+    }
+}
+
+int main() {
+    std::string text = "{} + {} = {}";
+    const std::string constant = "plain";
+    stdx::string s("caf\xC3\xA9 {}");
+    const stdx::string cs("no placeholders");
+    stdx::string_view v = s.view();
+    const char* pointer = "pointer {}";
+
+    expect("literal", format("literal"), "literal");
+    expect("literal with arguments", format("{} and {}", 1, "two"), "1 and two");
+    expect("std::string", format(constant), "plain");
+    expect("std::string with arguments", format(text, 1, 2, 3), "1 + 2 = 3");
+    expect("std::string temporary", format(std::string("{}!"), 'x'), "x!");
+    expect("stdx::string", format(cs), "no placeholders");
+    expect("stdx::string with arguments", format(s, 42), "caf\xC3\xA9 42");
+    expect("stdx::string temporary", format(stdx::string("{}:{}"), 1, 2), "1:2");
+    expect("stdx::string_view with arguments", format(v, 0.5), "caf\xC3\xA9 0.5");
+    expect("const char*", format(pointer), "pointer {}");
+    expect("runtime_format", format(stdx::runtime_format(pointer), 7), "pointer 7");
+    expect("runtime_format string_view", format(stdx::runtime_format(std::string_view(pointer)), 7), "pointer 7");
+#if !CPP_AT_LEAST(CPP20)
+    expect("const char* with arguments", format(pointer, 7), "pointer 7");
+    expect("string_view with arguments", format(std::string_view(pointer), 7), "pointer 7");
+#endif
+    expect("surplus arguments at run time", format(constant, 1, 2), "plain");
+
+    // the same forms through the printing functions themselves
+    stdx::Print("Print {}\n", 1);
+    stdx::PrintLine(text, 1, 2, 3);
+    stdx::PrintLine(s, "PrintLine");
+    stdx::PrintLine(cs);
+    stdx::PrintLine(v, 2);
+    stdx::PrintErr(constant);
+    stdx::PrintLineErr(s, "PrintLineErr");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+// hashing::hasher has AVX2, SSE2 and scalar lane code; all three must give
+// the digests below, and any split of the input across update() calls the
+// same digest as hashing it in one go. stdx::string hashes code points, so
+// the same text stored as Latin-1, UCS-2 or UTF-32 hashes alike, and a
+// cached hash is dropped by every write. Build it all three ways:
+//
+//   g++ -std=c++17 -O2 -I.. hash_digests.cpp -o hash_digests
+//   g++ -std=c++17 -O2 -mavx2 -I.. hash_digests.cpp -o hash_digests
+//   g++ -std=c++17 -O2 -mno-sse2 -I.. hash_digests.cpp -o hash_digests
+//   cl /std:c++17 /O2 /EHsc /I.. hash_digests.cpp
+//   cl /std:c++17 /O2 /EHsc /arch:AVX2 /I.. hash_digests.cpp
+//
+// With --emit it prints the digest table again (after a deliberate change
+// to the hash). Exits non-zero and names the first mismatch.
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "../stdxstring.h"
+
+using stdx::hashing::hasher;
+using stdx::hashing::hash_bytes;
+
+// Lengths on either side of the short-input cases, one stripe (64 bytes)
+// and one block of stripes (1024 bytes).
+static const size_t lengths[] = {
+    0, 1, 3, 4, 8, 9, 16, 17, 32, 33, 63, 64, 65, 127, 128, 129, 1023, 1024, 1025, 2048, 3073, 10000,
+};
+
+static const uint64_t expected[] = {
+    0xAF4D83A1F2CD0CA9ull, // 0
+    0x8B317DF68AE52BF9ull, // 1
+    0x9A559D18F778A2FDull, // 3
+    0x9D8432C7796FFCE3ull, // 4
+    0x05688FA9D4F4FBD6ull, // 8
+    0x3B7C1D266F3032D0ull, // 9
+    0x599C4A86372D5BA4ull, // 16
+    0x0DA826E1A6C5AA3Cull, // 17
+    0x858121E0545B61CBull, // 32
+    0x29A58E6381CD6E7Cull, // 33
+    0x1C338F85FAB56FEEull, // 63
+    0x63559A71CD6EFF19ull, // 64
+    0x3647E8A38CBF0854ull, // 65
+    0x877560D21A2395C4ull, // 127
+    0xED7FE2A58F0E4512ull, // 128
+    0x63F87E0DD43AF91Cull, // 129
+    0x09A4E9EFBCA0E39Full, // 1023
+    0x7BD0755A82904CADull, // 1024
+    0x05DE1849565A224Eull, // 1025
+    0xEE0F2C076F6D8374ull, // 2048
+    0xFCE9992EC3930AE8ull, // 3073
+    0x6C66E9D51C689C19ull, // 10000
+};
+
+static std::vector<unsigned char> input(size_t n) {
+    std::vector<unsigned char> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = (unsigned char)(i * 131 + 7 + (i >> 8));
+    return v;
+}
+
+static const char* lanes() {
+#if defined(STDX_UTF_AVX2)
+    return "AVX2";
+#elif defined(STDX_UTF_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+static int failures = 0, checked = 0;
+
+static void expect(bool ok, const char* what, size_t n) {
+    ++checked;
+    if (ok || failures++ >= 10) return;
+    printf("FAIL %s, %zu bytes (%s lanes)\n", what, n, lanes());
+}
+
+// Same text at every storage width, through views and owning strings.
+static void check_widths(const std::u32string& text) {
+    bool latin1 = true, ucs2 = true;
+    for (char32_t c : text) { latin1 = latin1 && c <= 0xFF; ucs2 = ucs2 && c <= 0xFFFF; }
+    uint64_t want = stdx::string_view(text.data(), text.size()).hash();
+    if (latin1) {
+        std::vector<unsigned char> narrow(text.begin(), text.end());
+        expect(stdx::string_view(narrow.data(), narrow.size()).hash() == want, "Latin-1 view hashes like UTF-32", text.size());
+    }
+    if (ucs2) {
+        std::u16string wide(text.begin(), text.end());
+        expect(stdx::string_view(wide.data(), wide.size()).hash() == want, "UCS-2 view hashes like UTF-32", text.size());
+    }
+    stdx::string s(text);
+    expect(s.hash() == want, "stdx::string hashes like its view", text.size());
+    // widened by a code point that is then removed: stored wider than needed
+    stdx::string widened(s);
+    widened.append(stdx::string(U"\U0001F600"));
+    widened.remove(widened.size() - 1, 1);
+    expect(widened.hash() == want, "string stored wider than needed", text.size());
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && !strcmp(argv[1], "--emit")) {
+        for (size_t n : lengths) {
+            std::vector<unsigned char> v = input(n);
+            printf("    0x%016llXull, // %zu\n", (unsigned long long)hash_bytes(v.data(), n), n);
+        }
+        return 0;
+    }
+
+    // fixed digests: every lane implementation must reproduce them
+    static_assert(std::size(expected) == std::size(lengths), "one digest per length");
+    for (size_t i = 0; i < std::size(lengths); ++i) {
+        std::vector<unsigned char> v = input(lengths[i]);
+        expect(hash_bytes(v.data(), v.size()) == expected[i], "digest differs from the table", lengths[i]);
+    }
+
+    // any split across update() calls
+    std::mt19937 rng(5);
+    for (size_t n : lengths) {
+        std::vector<unsigned char> v = input(n);
+        uint64_t want = hash_bytes(v.data(), n);
+        for (int round = 0; round < 200; ++round) {
+            hasher h;
+            for (size_t at = 0; at < n;) {
+                // mostly small pieces, sometimes a stripe or block exactly
+                size_t piece;
+                switch (rng() % 4) {
+                case 0: piece = 64; break;
+                case 1: piece = 1024; break;
+                default: piece = rng() % 100; break;
+                }
+                piece = std::min(piece, n - at);
+                h.update(v.data() + at, piece);
+                at += piece;
+            }
+            if (round % 7 == 0) h.update(v.data(), 0);
+            expect(h.digest() == want, "split update()", n);
+        }
+        // byte by byte, and the digest is repeatable
+        hasher h;
+        for (size_t i = 0; i < n; ++i) h.update(v.data() + i, 1);
+        expect(h.digest() == want && h.digest() == want, "byte-by-byte update()", n);
+    }
+
+    // storage width does not change the hash
+    static const char32_t letters[] = { U'a', U'z', 0xE9, 0xFF, 0x3B1, 0xFFFD, 0x1F600 };
+    for (size_t n : lengths) {
+        if (n > 1100) continue;
+        for (size_t top = 2; top <= std::size(letters); ++top) {
+            std::u32string text;
+            for (size_t i = 0; i < n; ++i) text += letters[rng() % top];
+            check_widths(text);
+        }
+    }
+
+    // a cached hash (heap strings only) must not survive a write
+    std::u32string base(200, U'q');
+    auto fresh = [](const stdx::string& s) { return s.view().hash(); };
+    {
+        stdx::string s(base);
+        size_t before = s.hash();
+        s[10] = U'r';
+        expect(s.hash() != before && s.hash() == fresh(s), "hash after operator[]", s.size());
+    }
+    {
+        stdx::string s(base);
+        s.hash();
+        s.append(stdx::string("tail"));
+        expect(s.hash() == fresh(s), "hash after append", s.size());
+    }
+    {
+        stdx::string s(base);
+        s.hash();
+        s.remove(0, 5);
+        expect(s.hash() == fresh(s), "hash after remove", s.size());
+    }
+    {
+        // take(): a move carries the cached hash to the new owner only
+        stdx::string s(base);
+        size_t h = s.hash();
+        stdx::string moved(std::move(s));
+        expect(moved.hash() == h && s.hash() == stdx::string().hash(), "hash after a move (take)", base.size());
+        stdx::string other(std::u32string(150, U'w'));
+        other.hash();
+        other = std::move(moved);
+        expect(other.hash() == h && other.hash() == fresh(other), "hash after a move assignment (take)", base.size());
+        other[0] = U'Q';
+        expect(other.hash() == fresh(other), "hash after writing a moved-into string", base.size());
+    }
+
+    if (!failures) printf("ok   %d checks, %s lanes\n", checked, lanes());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+// search::matcher reports leftmost-longest matches: of the patterns that
+// occur at or after a position, the one starting earliest wins, and of
+// those the longest. find_any and replace_all must follow that rule, so
+// overlapping patterns ({"abcd", "bc"}) replace as the longer one would.
+// Random pattern sets over a small alphabet, many of them prefixes,
+// suffixes and infixes of each other, are checked against a brute-force
+// scan.
+//
+//   g++ -std=c++17 -O2 -I.. matcher_matches.cpp -o matcher_matches
+//   cl /std:c++17 /O2 /EHsc /I.. matcher_matches.cpp
+//
+// Exits non-zero and prints the first mismatching pattern set.
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "../stdxstring.h"
+
+static size_t failures = 0, checked = 0;
+
+// Leftmost-longest by trying every start and every pattern.
+static stdx::search::match reference(const std::vector<std::u32string>& patterns, const std::u32string& text, size_t from) {
+    for (size_t i = from; i < text.size(); ++i) {
+        stdx::search::match best;
+        for (size_t p = 0; p < patterns.size(); ++p) {
+            const std::u32string& x = patterns[p];
+            if (x.empty() || x.size() <= best.length || text.compare(i, x.size(), x) != 0) continue;
+            best = stdx::search::match{ i, x.size(), p };
+        }
+        if (best) return best;
+    }
+    return stdx::search::match{};
+}
+
+static std::string utf8(const std::u32string& s) {
+    return std::string(stdx::string(s));
+}
+
+static void expect(bool ok, const char* what, const std::vector<std::u32string>& patterns, const std::u32string& text) {
+    ++checked;
+    if (ok || failures++ >= 5) return;
+    printf("FAIL %s on \"%s\", patterns", what, utf8(text).c_str());
+    for (const auto& p : patterns) printf(" \"%s\"", utf8(p).c_str());
+    printf("\n");
+}
+
+int main() {
+    // the case from the review: the chained replace() calls give x[ABCD]x
+    {
+        std::vector<stdx::string> patterns = { "abcd", "bc" };
+        stdx::search::matcher m(patterns);
+        stdx::string text("xabcdx");
+        stdx::string replaced = text.replace_all(m, { "[ABCD]", "[BC]" });
+        stdx::string chained = text.replace("abcd", "[ABCD]").replace("bc", "[BC]");
+        expect(replaced == "x[ABCD]x" && replaced == chained, "replace_all on overlapping patterns", { U"abcd", U"bc" }, U"xabcdx");
+        stdx::search::match hit = text.find_any(m);
+        expect(hit.pos == 1 && hit.length == 4 && hit.pattern == 0, "find_any on overlapping patterns", { U"abcd", U"bc" }, U"xabcdx");
+    }
+    // the shorter pattern still wins where the longer one does not occur,
+    // and a match that starts earlier beats a longer one that starts later
+    {
+        std::vector<std::u32string> patterns = { U"abcd", U"bc", U"ab", U"bcdef" };
+        stdx::search::matcher m(patterns);
+        stdx::string text(U"abcx bcx abcdefg");
+        expect(text.replace_all(m, { "1", "2", "3", "4" }) == "3cx 2x 1efg", "replace_all, mixed overlaps", patterns, U"abcx bcx abcdefg");
+    }
+
+    static const char32_t alphabet[] = { U'a', U'b', U'c', 0xE9, 0x3B1 };
+    std::mt19937 rng(11);
+    for (int round = 0; round < 20000 && failures == 0; ++round) {
+        size_t letters = 2 + rng() % 4;
+        auto word = [&](size_t n) {
+            std::u32string w;
+            while (n--) w += alphabet[rng() % letters];
+            return w;
+        };
+
+        std::vector<std::u32string> patterns;
+        for (size_t k = 1 + rng() % 6; k--;) {
+            // new words, or pieces of earlier ones so patterns overlap
+            if (patterns.empty() || rng() % 2) patterns.push_back(word(rng() % 6));
+            else {
+                const std::u32string& w = patterns[rng() % patterns.size()];
+                size_t at = w.empty() ? 0 : rng() % w.size();
+                patterns.push_back(rng() % 2 ? w.substr(at) + word(rng() % 3) : word(rng() % 3) + w.substr(0, at));
+            }
+        }
+        std::u32string text = word(rng() % 60);
+        stdx::search::matcher m(patterns);
+        stdx::string s(text);
+
+        // every match, resuming after each one
+        std::vector<stdx::search::match> want;
+        for (auto r = reference(patterns, text, 0); r; r = reference(patterns, text, r.pos + r.length)) want.push_back(r);
+        std::vector<stdx::search::match> got;
+        m.find_all(text.data(), text.size(), [&](const stdx::search::match& r) { got.push_back(r); });
+        bool same = got.size() == want.size();
+        for (size_t i = 0; same && i < got.size(); ++i) {
+            // equal patterns share a match, reported under the first index
+            same = got[i].pos == want[i].pos && got[i].length == want[i].length && got[i].pattern == want[i].pattern;
+        }
+        expect(same, "find_all", patterns, text);
+
+        size_t from = rng() % (text.size() + 1);
+        auto r = reference(patterns, text, from);
+        auto a = s.find_any(m, from);
+        expect(a.pos == r.pos && a.length == r.length, "find_any", patterns, text);
+
+        // replace_all against the same splice done by hand
+        std::vector<stdx::string> replacements;
+        for (size_t i = 0; i < patterns.size(); ++i) replacements.push_back(stdx::string("<") + std::to_string(i) + ">");
+        std::u32string spliced;
+        size_t pos = 0;
+        for (const auto& w : want) {
+            spliced += text.substr(pos, w.pos - pos);
+            spliced += std::u32string(U"<") + (char32_t)(U'0' + w.pattern) + U">";
+            pos = w.pos + w.length;
+        }
+        spliced += text.substr(pos);
+        expect(s.replace_all(m, replacements) == stdx::string(spliced), "replace_all", patterns, text);
+    }
+
+    if (!failures) printf("ok   %zu matcher checks\n", checked);
+    return failures ? 1 : 0;
+}
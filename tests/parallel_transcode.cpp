@@ -0,0 +1,127 @@
+// A conversion cut into chunks for utf::parallel_for must give the same
+// result as the serial path: fromUtf8/appendUtf8 (appendUtf8Parallel) the
+// same code points at the same width, with the same U+FFFDs for ill-formed
+// input even where a truncated or stray sequence straddles a chunk cut, and
+// the UTF-8 encode (encodeUtf8) byte-identical UTF-8. The threshold is
+// lowered so megabyte inputs split, with std::threads and with a runner.
+//
+//   g++ -std=c++17 -O2 -pthread -I.. parallel_transcode.cpp -o parallel_transcode
+//   g++ -std=c++17 -O1 -g -pthread -fsanitize=thread -I.. parallel_transcode.cpp -o parallel_transcode
+//   cl /std:c++17 /O2 /EHsc /I.. parallel_transcode.cpp
+//
+// Exits non-zero and names the first input that converted differently.
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "../stdxstring.h"
+
+static int failures = 0, checked = 0;
+
+static void expect(bool ok, const char* what, size_t bytes, size_t chunks) {
+    ++checked;
+    if (ok || failures++ >= 10) return;
+    printf("FAIL %s, %zu units in %zu chunks\n", what, bytes, chunks);
+}
+
+// Runs the conversion with the given split (1: serial).
+template<typename F>
+static void with_chunks(unsigned threads, bool serial, F&& f) {
+    stdx::utf::parallel_options& o = stdx::utf::parallel();
+    o.threshold = serial ? (size_t)-1 : 0;
+    o.threads = threads;
+    f();
+}
+
+// Random UTF-8 of every length, with ill-formed sequences planted around
+// each place the input will be cut.
+static std::string make_input(std::mt19937& rng, size_t n, size_t chunks, char32_t top) {
+    static const char* const broken[] = {
+        "\xE2\x82",             // truncated three-byte sequence
+        "\xF0\x9F\x98",         // truncated four-byte sequence
+        "\x80\x80\x80\x80\x80", // stray continuation bytes, which move the cut
+        "\xC0\xAF",             // overlong
+        "\xED\xA0\x80",         // encoded surrogate
+        "\xF4\x90\x80\x80",     // above U+10FFFF
+        "\xFF",
+    };
+    std::string s;
+    while (s.size() < n) {
+        char32_t c = rng() % 4 ? U'a' + rng() % 26 : (char32_t)(rng() % (top + 1));
+        if (c >= 0xD800 && c <= 0xDFFF) c = 0xFFFD;
+        s += std::string(stdx::string(std::u32string(1, c)));
+    }
+    for (size_t i = 1; i < chunks; ++i) {
+        size_t cut = n / chunks * i;
+        for (int k = 0; k < 3; ++k) {
+            const char* b = broken[rng() % std::size(broken)];
+            size_t at = cut - std::min(cut, (size_t)(rng() % 6));
+            s.replace(at, std::min(strlen(b), s.size() - at), b);
+        }
+    }
+    return s;
+}
+
+static void check_decode(const std::string& utf8, unsigned threads, const char* what) {
+    stdx::string serial, parallel;
+    with_chunks(threads, true, [&] { serial = stdx::string(utf8); });
+    with_chunks(threads, false, [&] { parallel = stdx::string(utf8); });
+    size_t chunks = stdx::utf::parallel_chunks(utf8.size());
+    expect(chunks > 1, "input too small to split", utf8.size(), chunks);
+    expect(parallel.size() == serial.size() && parallel.width() == serial.width() && parallel == serial, what, utf8.size(), chunks);
+
+    // appended to text already there, which the chunks are offset by
+    stdx::string prefix_serial("prefix \xCE\xB1"), prefix_parallel("prefix \xCE\xB1");
+    with_chunks(threads, true, [&] { prefix_serial.append(utf8); });
+    with_chunks(threads, false, [&] { prefix_parallel.append(utf8); });
+    expect(prefix_parallel.width() == prefix_serial.width() && prefix_parallel == prefix_serial, "appendUtf8 after a prefix", utf8.size(), chunks);
+}
+
+static void check_encode(const stdx::string& s, unsigned threads) {
+    std::string serial, parallel;
+    with_chunks(threads, true, [&] { serial = std::string(s); });
+    with_chunks(threads, false, [&] { parallel = std::string(s); });
+    expect(stdx::utf::parallel_chunks(s.size()) > 1, "string too small to split", s.size(), 1);
+    expect(parallel == serial, "parallel encode", s.size(), stdx::utf::parallel_chunks(s.size()));
+}
+
+int main() {
+    std::mt19937 rng(18);
+    static const char32_t tops[] = { 0x7F, 0xFF, 0xFFFF, 0x10FFFF };
+    for (int round = 0; round < 24; ++round) {
+        unsigned threads = 2 + round % 7;
+        size_t n = (threads + rng() % 4) * 64 * 1024 + rng() % 1000;
+        char32_t top = tops[round % 4];
+        std::string utf8 = make_input(rng, n, std::min<size_t>(threads, n / (64 * 1024)), top);
+        check_decode(utf8, threads, "parallel decode");
+
+        // code points, lone surrogates included, back to UTF-8
+        stdx::string decoded(utf8), copy(decoded);
+        while (decoded.size() < threads * 64 * 1024) decoded.append(copy);
+        check_encode(decoded, threads);
+        std::u32string wide(decoded.size(), U'x');
+        for (size_t i = 0; i < wide.size(); i += 1 + rng() % 5000) wide[i] = 0xD800 + rng() % 0x800;
+        check_encode(stdx::string(wide), threads);
+    }
+
+    // input that is nothing but continuation bytes past the first cut
+    {
+        std::string utf8 = "ab" + std::string(300 * 1024, '\x80') + "\xC3\xA9z";
+        check_decode(utf8, 4, "run of continuation bytes");
+    }
+
+    // the chunks handed to a runner, here run in reverse on this thread
+    stdx::utf::parallel().runner = [](size_t count, const std::function<void(size_t)>& task) {
+        for (size_t i = count; i--;) task(i);
+    };
+    {
+        std::string utf8 = make_input(rng, 600 * 1024, 5, 0x10FFFF);
+        check_decode(utf8, 5, "parallel decode through a runner");
+        check_encode(stdx::string(utf8), 5);
+    }
+    stdx::utf::parallel() = stdx::utf::parallel_options();
+
+    if (!failures) printf("ok   %d parallel transcode checks\n", checked);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+// parse / try_parse take exactly what std::from_chars takes: digits in the
+// given base (no "0x"), no leading space or '+', nothing left over, ASCII
+// digits only however the text is stored, and a value that fits T.
+// append_number and to_string give the same text as std::to_chars: the
+// shortest digits that read back unless a precision is given. Both must
+// hold with the library's floating-point to_chars/from_chars and with the
+// printf/strtod fallback, so build it both ways:
+//
+//   g++ -std=c++17 -I.. parse_numbers.cpp -o parse_numbers
+//   g++ -std=c++17 -DSTDX_NO_FLOAT_TO_CHARS -I.. parse_numbers.cpp -o parse_numbers
+//   cl /std:c++17 /EHsc /I.. parse_numbers.cpp
+//
+// Exits non-zero and names the failing text on a mismatch.
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include "../stdxstring.h"
+
+static int failures = 0, checked = 0;
+
+static void expect(bool ok, const char* what, const stdx::string& text) {
+    ++checked;
+    if (ok || failures++ >= 10) return;
+    printf("FAIL %s: \"%s\"\n", what, std::string(text).c_str());
+}
+
+template<typename T>
+static void parses(const stdx::string& text, T want) {
+    std::optional<T> got = text.try_parse<T>();
+    expect(got && (*got == want || (std::isnan((double)*got) && std::isnan((double)want))), "try_parse", text);
+    expect(std::signbit((double)text.parse<T>()) == std::signbit((double)want), "parse sign", text);
+}
+
+template<typename T>
+static void rejects(const stdx::string& text) {
+    expect(!text.try_parse<T>(), "try_parse accepted", text);
+    bool threw = false;
+    try { text.parse<T>(); }
+    catch (const std::invalid_argument&) { threw = true; }
+    expect(threw, "parse did not throw invalid_argument", text);
+}
+
+template<typename T>
+static void out_of_range(const stdx::string& text) {
+    expect(!text.try_parse<T>(), "try_parse accepted", text);
+    bool threw = false;
+    try { text.parse<T>(); }
+    catch (const std::out_of_range&) { threw = true; }
+    expect(threw, "parse did not throw out_of_range", text);
+}
+
+template<typename T>
+static void hex(const stdx::string& text, int base, std::optional<T> want) {
+    std::optional<T> got = text.try_parse<T>(base);
+    expect(got == want, "try_parse with a base", text);
+}
+
+template<typename T, typename... Format>
+static void prints(T value, const char* want, Format... format) {
+    stdx::string s;
+    s.append_number(value, format...);
+    expect(s == want, want, s);
+}
+
+// Stored one unit wider than it needs, to take the narrowing path.
+static stdx::string widened(const char* text) {
+    stdx::string s(text);
+    s.append(stdx::string("\xCE\xB1"));
+    s.remove(s.size() - 1, 1);
+    return s;
+}
+
+int main() {
+    // integers
+    parses<int>("42", 42);
+    parses<int>("-42", -42);
+    parses<int>("0", 0);
+    parses<long long>("-9223372036854775808", std::numeric_limits<long long>::min());
+    parses<uint64_t>("18446744073709551615", std::numeric_limits<uint64_t>::max());
+    for (const char* bad : { "", "-", "+42", " 42", "42 ", "4 2", "42x", "0x2a", "1e3", "4.0", "--1" }) rejects<int>(bad);
+    rejects<unsigned>("-1");
+
+    // bases
+    hex<int>("ff", 16, 255);
+    hex<int>("FF", 16, 255);
+    hex<int>("-1a", 16, -26);
+    hex<unsigned>("7fffffff", 16, 0x7FFFFFFFu);
+    hex<int>("zz", 36, 1295);
+    hex<int>("101", 2, 5);
+    hex<int>("0xff", 16, std::nullopt);
+    hex<int>("fg", 16, std::nullopt);
+    hex<int>("102", 2, std::nullopt);
+    hex<int>("+ff", 16, std::nullopt);
+    hex<unsigned>("-ff", 16, std::nullopt);
+    hex<int8_t>("80", 16, std::nullopt);
+    hex<int8_t>("-80", 16, (int8_t)-128);
+    {
+        bool threw = false;
+        try { stdx::string("100").parse<uint8_t>(16); }
+        catch (const std::out_of_range&) { threw = true; }
+        expect(threw, "parse with a base did not throw out_of_range", "100");
+    }
+
+    // overflow
+    parses<int8_t>("127", 127);
+    parses<int8_t>("-128", -128);
+    out_of_range<int8_t>("128");
+    out_of_range<int8_t>("-129");
+    out_of_range<uint8_t>("256");
+    out_of_range<int>("99999999999");
+    out_of_range<uint64_t>("18446744073709551616");
+    out_of_range<double>("1e400");
+    out_of_range<double>("-1e400");
+    out_of_range<float>("1e39");
+    out_of_range<double>("1e-400");
+
+    // floating point
+    parses<double>("1.5", 1.5);
+    parses<double>("-0.25", -0.25);
+    parses<double>("-0", -0.0);
+    parses<double>("1e3", 1000.0);
+    parses<double>("1E-3", 0.001);
+    parses<double>(".5", 0.5);
+    parses<double>("5.", 5.0);
+    parses<double>("4.9406564584124654e-324", 4.9406564584124654e-324);
+    parses<double>("inf", std::numeric_limits<double>::infinity());
+    parses<double>("-Infinity", -std::numeric_limits<double>::infinity());
+    parses<double>("nan", std::numeric_limits<double>::quiet_NaN());
+    parses<float>("0.1", 0.1f);
+    parses<long double>("0.1", 0.1L);
+    for (const char* bad : { "", "-", ".", "e5", "1e", "1e+", "1.5x", "1.5 ", " 1.5", "+1.5", "1..5", "0x1p3", "-0x10", "in", "1,5" }) rejects<double>(bad);
+
+    // only ASCII digits, however the text is stored
+    parses<int>(widened("123"), 123);
+    parses<double>(widened("-2.5e1"), -25.0);
+    hex<int>(widened("ff"), 16, 255);
+    rejects<int>("12\xC2\xB2");                     // superscript two (Latin-1)
+    rejects<int>("\xC2\xBD");                       // one half (Latin-1)
+    rejects<int>("\xD9\xA1\xD9\xA2\xD9\xA3");       // Arabic-Indic 123
+    rejects<int>("\xEF\xBC\x91\xEF\xBC\x92");       // fullwidth 12
+    rejects<double>("\xE0\xA5\xA7.\xE0\xA5\xAB");   // Devanagari 1.5
+    rejects<double>("1.5\xF0\x9D\x9F\x8E");         // mathematical bold zero
+    rejects<int>(widened("12 "));
+
+    // append_number: shortest round-trip text, fixed or scientific
+    prints(0.1, "0.1");
+    prints(0.0, "0");
+    prints(-0.0, "-0");
+    prints(100.0, "100");
+    prints(123456.0, "123456");
+    prints(1e5, "1e+05");
+    prints(0.001, "0.001");
+    prints(0.0001, "1e-04");
+    prints(1e-7, "1e-07");
+    prints(1e20, "1e+20");
+    prints(123456789012345680000.0, "123456789012345683968");
+    prints(1.5e300, "1.5e+300");
+    prints(5e-324, "5e-324");
+    prints(std::numeric_limits<double>::max(), "1.7976931348623157e+308");
+    prints(0.3f, "0.3");
+    prints(1e10f, "1e+10");
+    prints(16777216.0f, "16777216");
+    prints(0.1L, "0.1");
+    prints(std::numeric_limits<double>::infinity(), "inf");
+    prints(-std::numeric_limits<double>::infinity(), "-inf");
+    prints(42, "42");
+    prints(-7, "-7");
+    prints(255, "ff", 16);
+
+    // with a format, and with a precision
+    prints(1e22, "10000000000000000000000", std::chars_format::fixed);
+    prints(0.1, "0.1", std::chars_format::fixed);
+    prints(1234.5, "1.2345e+03", std::chars_format::scientific);
+    prints(1e-5, "1e-05", std::chars_format::general);
+    prints(1234.5, "1234.5", std::chars_format::general);
+    prints(9276988.0, "9.276988e+06", std::chars_format::general);
+    prints(123456.0, "123456", std::chars_format::general);
+    prints(0.0001, "0.0001", std::chars_format::general);
+    prints(1.0, "1p+0", std::chars_format::hex);
+    prints(-0.1, "-1.999999999999ap-4", std::chars_format::hex);
+    prints(3.14159, "3.14", std::chars_format::fixed, 2);
+    prints(2.25L, "2.2", std::chars_format::fixed, 1);
+    prints(1234.5, "1.23e+03", std::chars_format::scientific, 2);
+    prints(0.5, "0.5", std::chars_format::general, 3);
+    prints(1.0, "1.00p+0", std::chars_format::hex, 2);
+    {
+        // longer than append_number's stack buffer
+        stdx::string s;
+        s.append_number(1e300, std::chars_format::fixed, 2);
+        expect(s.size() == 304 && s.starts_with("1000000000000000052504760255") && s.ends_with(".00"), "fixed 1e300", s);
+    }
+    expect(stdx::string::to_string(0.1) == "0.100000", "to_string(double)", "0.1");
+    expect(stdx::string::to_string(-1.0 / 3, 3) == "-0.333", "to_string(double, precision)", "-1/3");
+    expect(stdx::string::to_string(2.5f, 1) == "2.5", "to_string(float, precision)", "2.5f");
+
+    // random bit patterns read back exactly
+    std::mt19937_64 rng(16);
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t bits = rng();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (!std::isfinite(d)) continue;
+        stdx::string s;
+        s.append_number(d);
+        std::optional<double> back = s.try_parse<double>();
+        expect(back && memcmp(&*back, &d, sizeof(d)) == 0, "double round trip", s);
+        float f;
+        uint32_t fbits = (uint32_t)bits;
+        memcpy(&f, &fbits, sizeof(f));
+        if (!std::isfinite(f)) continue;
+        stdx::string t;
+        t.append_number(f);
+        std::optional<float> fback = t.try_parse<float>();
+        expect(fback && memcmp(&*fback, &f, sizeof(f)) == 0, "float round trip", t);
+    }
+
+#if defined(STDX_FLOAT_TO_CHARS)
+    const char* floats = "std::to_chars / std::from_chars";
+#else
+    const char* floats = "snprintf / strtod";
+#endif
+    if (!failures) printf("ok   %d checks, floats by %s\n", checked, floats);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+// search::find, rfind and find_all pick an algorithm by needle length and
+// unit width (memchr, the SIMD first/last filter, Horspool, Two-Way with
+// its shift memory). All of them must return what a naive scan does. The
+// texts use two- and three-letter alphabets and periodic needles longer
+// than 32 units, which is where Two-Way's memory and critical
+// factorization matter; every haystack/needle width pair is tried, from
+// a non-zero start as well.
+//
+//   g++ -std=c++17 -O2 -I.. search_find.cpp -o search_find
+//   g++ -std=c++17 -O2 -mavx2 -I.. search_find.cpp -o search_find
+//   cl /std:c++17 /O2 /EHsc /I.. search_find.cpp
+//
+// Exits non-zero and prints the first mismatching case.
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../stdxsearch.h"
+
+using text = std::vector<char32_t>;
+
+static size_t naive_find(const text& h, const text& x, size_t from) {
+    if (from > h.size() || h.size() - from < x.size()) return stdx::search::npos;
+    for (size_t i = from; i + x.size() <= h.size(); ++i) {
+        if (std::equal(x.begin(), x.end(), h.begin() + i)) return i;
+    }
+    return stdx::search::npos;
+}
+
+static size_t naive_rfind(const text& h, const text& x) {
+    if (x.size() > h.size()) return stdx::search::npos;
+    for (size_t i = h.size() - x.size() + 1; i-- > 0;) {
+        if (std::equal(x.begin(), x.end(), h.begin() + i)) return i;
+    }
+    return stdx::search::npos;
+}
+
+static size_t failures = 0, checked = 0;
+
+template<typename Unit>
+static bool fits(const text& t) {
+    for (char32_t c : t) if (c > stdx::search::detail::unit_max<Unit>()) return false;
+    return true;
+}
+
+static void report(const char* what, size_t ha, size_t nb, const text& h, const text& x, size_t from, size_t got, size_t want) {
+    if (failures++ >= 5) return;
+    printf("FAIL %s, %zu-byte haystack of %zu, %zu-byte needle of %zu, from %zu: got %zd, expected %zd\n",
+        what, ha, h.size(), nb, x.size(), from, (ptrdiff_t)got, (ptrdiff_t)want);
+}
+
+template<typename A, typename B>
+static void check(const text& h, const text& x, size_t from) {
+    if (!fits<A>(h) || !fits<B>(x)) return;
+    std::vector<A> hay(h.begin(), h.end());
+    std::vector<B> needle(x.begin(), x.end());
+    const A* hp = hay.data();
+    const B* np = needle.data();
+    ++checked;
+
+    size_t want = naive_find(h, x, from);
+    size_t got = stdx::search::find(hp, hay.size(), np, needle.size(), from);
+    if (got != want) report("find", sizeof(A), sizeof(B), h, x, from, got, want);
+
+    want = naive_rfind(h, x);
+    got = stdx::search::rfind(hp, hay.size(), np, needle.size());
+    if (got != want) report("rfind", sizeof(A), sizeof(B), h, x, from, got, want);
+
+    if (!x.empty()) {
+        size_t expected = 0;
+        for (size_t p = naive_find(h, x, 0); p != stdx::search::npos; p = naive_find(h, x, p + x.size())) ++expected;
+        size_t count = stdx::search::find_all(hp, hay.size(), np, needle.size(), [](size_t) {});
+        if (count != expected) report("find_all", sizeof(A), sizeof(B), h, x, 0, count, expected);
+    }
+}
+
+template<typename A>
+static void check_needles(const text& h, const text& x, size_t from) {
+    check<A, unsigned char>(h, x, from);
+    check<A, char16_t>(h, x, from);
+    check<A, char32_t>(h, x, from);
+}
+
+static void check_all(const text& h, const text& x, size_t from) {
+    check_needles<unsigned char>(h, x, from);
+    check_needles<char16_t>(h, x, from);
+    check_needles<char32_t>(h, x, from);
+}
+
+int main() {
+    // the last letters only fit the wider widths
+    static const char32_t letters[] = { U'a', U'b', U'c', 0xE9, 0x3B1, 0x1F600 };
+    std::mt19937 rng(2024);
+
+    for (int round = 0; round < 20000 && failures == 0; ++round) {
+        size_t alphabet = 2 + rng() % 2;
+        bool wide = rng() % 4 == 0;
+        auto letter = [&]() {
+            char32_t c = letters[rng() % alphabet];
+            if (wide && rng() % 8 == 0) c = letters[3 + rng() % 3];
+            return c;
+        };
+
+        // needles: random, or a period repeated past the short-needle limit
+        text x;
+        size_t m;
+        switch (rng() % 4) {
+        case 0: m = rng() % 8; break;
+        case 1: m = 8 + rng() % 40; break;
+        default: m = 33 + rng() % 100; break;
+        }
+        if (rng() % 2) {
+            text period;
+            for (size_t i = 1 + rng() % 5; i--;) period.push_back(letter());
+            while (x.size() < m) x.push_back(period[x.size() % period.size()]);
+            if (m && rng() % 2) x[rng() % m] = letter(); // near-periodic
+        }
+        else {
+            for (size_t i = 0; i < m; ++i) x.push_back(letter());
+        }
+
+        // haystacks: random over the same alphabet, or built from copies of
+        // the needle and its prefixes so matches and near misses are common
+        text h;
+        size_t n = rng() % 600;
+        while (h.size() < n) {
+            switch (rng() % 3) {
+            case 0: h.push_back(letter()); break;
+            case 1: h.insert(h.end(), x.begin(), x.end()); break;
+            default: h.insert(h.end(), x.begin(), x.begin() + (x.empty() ? 0 : rng() % x.size())); break;
+            }
+        }
+
+        size_t from = rng() % 3 == 0 ? 0 : rng() % (h.size() + 2);
+        check_all(h, x, from);
+    }
+
+    if (!failures) printf("ok   %zu searches match a naive scan\n", checked);
+    return failures ? 1 : 0;
+}
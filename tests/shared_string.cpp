@@ -0,0 +1,118 @@
+// shared_string copies and substrings share one reference-counted block:
+// use_count() must follow every copy, move, assignment and destruction, a
+// substr() must share its parent's block and stay readable after the
+// parent is gone, str() must give back the text it was frozen from, and
+// the hash taken at freeze time must equal stdx::string::hash(). Build it
+// with the sanitizers too, so a block freed early or never freed shows up:
+//
+//   g++ -std=c++17 -O2 -pthread -I.. shared_string.cpp -o shared_string
+//   g++ -std=c++17 -O1 -g -pthread -fsanitize=address,undefined -I.. shared_string.cpp -o shared_string
+//   cl /std:c++17 /O2 /EHsc /I.. shared_string.cpp
+//
+// Exits non-zero and names the first check that failed.
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../stdxshared.h"
+
+static int failures = 0, checked = 0;
+
+static void expect(bool ok, const char* what) {
+    ++checked;
+    if (ok) return;
+    printf("FAIL %s\n", what);
+    ++failures;
+}
+
+int main() {
+    // reference counting
+    {
+        stdx::shared_string a(stdx::string("frozen text"));
+        expect(a.use_count() == 1, "one owner after freezing");
+        {
+            stdx::shared_string b(a);
+            stdx::shared_string c = b;
+            expect(a.use_count() == 3 && c.use_count() == 3, "copies share the block");
+            stdx::shared_string d(std::move(c));
+            expect(a.use_count() == 3 && c.use_count() == 0 && c.empty() && d == a, "a move transfers the reference");
+            d = d;
+            expect(a.use_count() == 3 && d == a, "self-assignment");
+            stdx::shared_string other(stdx::string("other"));
+            d = other;
+            expect(a.use_count() == 2 && other.use_count() == 2, "assignment drops the old block");
+            swap(b, other);
+            expect(a.use_count() == 2 && b == "other" && other == a, "swap");
+        }
+        expect(a.use_count() == 1, "copies gone");
+        stdx::shared_string empty;
+        expect(empty.use_count() == 0 && stdx::shared_string(stdx::string()).use_count() == 0, "empty text has no block");
+    }
+
+    // copies made and dropped on many threads at once
+    {
+        stdx::shared_string s(stdx::string(std::u32string(500, U'\U0001F600')));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([s] {
+                std::vector<stdx::shared_string> copies;
+                for (int i = 0; i < 10000; ++i) {
+                    copies.push_back(s);
+                    if (copies.size() > 50) copies.clear();
+                    copies.push_back(s.substr(i % 500, 3));
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        expect(s.use_count() == 1, "use_count after threads copy and drop");
+    }
+
+    // substr shares the parent's block and outlives the parent
+    {
+        stdx::shared_string sub, subsub;
+        {
+            stdx::shared_string parent(stdx::string(U"héllo αβγ wörld"));
+            sub = parent.substr(6, 9);
+            expect(parent.use_count() == 2 && sub.use_count() == 2, "substr shares the block");
+            subsub = sub.substr(4);
+            expect(parent.use_count() == 3 && subsub == stdx::string(U"wörld"), "substr of a substr");
+            expect(parent.substr(100).empty() && parent.substr(3, 100) == stdx::string(U"lo αβγ wörld"), "substr clamps");
+            expect(sub.width() == parent.width() && parent.width() == 2, "substr keeps the block's width");
+        }
+        expect(sub.use_count() == 2 && sub == stdx::string(U"αβγ wörld"), "substr after the parent is gone");
+        expect(sub[0] == 0x3B1 && subsub[1] == 0xF6, "reading a substr after the parent is gone");
+        sub = stdx::shared_string();
+        expect(subsub.use_count() == 1 && subsub.str() == stdx::string(U"wörld"), "last substr owns the block");
+    }
+
+    // str() round-trips, and the freeze-time hash is stdx::string::hash()
+    static const char32_t* const texts[] = {
+        U"a", U"short", U"café au lait, long enough for the heap: 0123456789",
+        U"中文 and αβγ", U"astral \U0001F600\U0010FFFF", U"embedded\0nul",
+    };
+    std::unordered_set<stdx::shared_string> seen;
+    for (const char32_t* t : texts) {
+        std::u32string u(t);
+        if (u == U"embedded") u = std::u32string(U"embedded\0nul", 12);
+        stdx::string s(u);
+        stdx::shared_string frozen(s);
+        expect(frozen.str() == s && frozen.size() == s.size() && frozen == s, "str() round-trip");
+        expect(frozen.hash() == s.hash() && std::hash<stdx::shared_string>()(frozen) == s.hash(), "freeze-time hash is stdx::string::hash()");
+        stdx::shared_string part = frozen.substr(1, frozen.size() - 2);
+        expect(part.hash() == s.substr(1, s.size() - 2).hash(), "substr hash is its text's hash");
+        // frozen from a string stored wider than it needs: narrowed, same hash
+        stdx::string wide(s);
+        wide.append(stdx::string(U"\U0001F600"));
+        wide.remove(wide.size() - 1, 1);
+        stdx::shared_string narrowed(wide);
+        expect(narrowed.width() == frozen.width() && narrowed.hash() == frozen.hash() && narrowed == frozen, "frozen at the narrowest width");
+        seen.insert(frozen);
+    }
+    expect(seen.size() == std::size(texts), "distinct texts in an unordered_set");
+    expect(stdx::shared_string().hash() == stdx::string().hash(), "empty hash");
+
+    if (!failures) printf("ok   %d shared_string checks\n", checked);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+// stdx::string must hand a memory resource back the size and alignment
+// each block was allocated with, as sized resources (the pool resources)
+// rely on it.
+//
+//   g++ -std=c++17 -I.. string_deallocate_sizes.cpp -o string_deallocate_sizes
+//   cl /std:c++17 /EHsc /I.. string_deallocate_sizes.cpp
+//
+// Exits non-zero and names the failing case on a mismatch.
+#include <cstdio>
+#include <map>
+#include <memory_resource>
+#include <vector>
+#include "../stdxstring.h"
+
+// Records every live block and checks each deallocation against it.
+class checking_resource : public std::pmr::memory_resource {
+public:
+    size_t mismatches = 0;
+
+    size_t live() const { return m_blocks.size(); }
+
+private:
+    struct block { size_t bytes, alignment; };
+    std::map<void*, block> m_blocks;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        m_blocks[p] = { bytes, alignment };
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        auto it = m_blocks.find(p);
+        if (it == m_blocks.end() || it->second.bytes != bytes || it->second.alignment != alignment) {
+            ++mismatches;
+            if (it == m_blocks.end()) printf("  unknown block %p\n", p);
+            else printf("  block of %zu bytes freed as %zu (alignment %zu as %zu)\n", it->second.bytes, bytes, it->second.alignment, alignment);
+            if (it == m_blocks.end()) return;
+            bytes = it->second.bytes;
+            alignment = it->second.alignment;
+        }
+        m_blocks.erase(it);
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+static int failures = 0;
+
+template<typename F>
+static void check(const char* name, F&& f) {
+    checking_resource resource;
+    f(stdx::string::allocator_type(&resource));
+    if (resource.mismatches || resource.live()) {
+        printf("FAIL %s: %zu mismatched deallocations, %zu blocks leaked\n", name, resource.mismatches, resource.live());
+        ++failures;
+    }
+    else {
+        printf("ok   %s\n", name);
+    }
+}
+
+int main() {
+    using alloc = stdx::string::allocator_type;
+    const char* long_text = "a string long enough to need a heap block of its own";
+
+    check("heap to heap growth", [&](alloc a) {
+        stdx::string s(long_text, a);
+        for (int i = 0; i < 8; ++i) s += s.view();
+    });
+
+    check("shrink_to_fit back to local", [&](alloc a) {
+        stdx::string s(long_text, a);
+        s.resize(3);
+        s.shrink_to_fit();
+    });
+
+    check("widening moves back to local", [&](alloc a) {
+        stdx::string s(long_text, a);
+        s.resize(3);
+        s += std::wstring(L"中"); // a UCS-2 code point: the widened string fits locally
+    });
+
+    check("widening to UTF-32 on the heap", [&](alloc a) {
+        stdx::string s(long_text, a);
+        s.push_back(U'\U0001F600');
+        s.shrink_to_fit();
+    });
+
+    check("narrowing shrink_to_fit", [&](alloc a) {
+        stdx::string s(long_text, a);
+        s += std::wstring(L"中");
+        s.remove(s.size() - 1, 1);
+        s.shrink_to_fit();
+    });
+
+    check("copy, move and assignment", [&](alloc a) {
+        stdx::string s(long_text, a);
+        stdx::string copy(s, a);
+        stdx::string moved(std::move(copy), a);
+        stdx::string target(a);
+        target = moved;
+        target = std::move(s);
+        target = stdx::string("short", a);
+    });
+
+    check("c_str buffers", [&](alloc a) {
+        stdx::string s(L"café and a long enough tail for the heap", a);
+        s.c_str<stdx::string::utf8_t>();
+        s.c_str<stdx::string::utf16_t>();
+        s.c_str<stdx::string::utf32_t>();
+        s.resize(2);
+        s.shrink_to_fit();
+    });
+
+    check("transforms in the string's resource", [&](alloc a) {
+        stdx::string s(long_text, a);
+        std::vector<stdx::string> parts = s.split(U' ');
+        stdx::string joined = stdx::string::join(parts, stdx::string(","), a);
+        stdx::string upper = joined.to_upper();
+        upper.resize(4);
+        upper.shrink_to_fit();
+    });
+
+    return failures ? 1 : 0;
+}
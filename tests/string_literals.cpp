@@ -0,0 +1,80 @@
+// "text"_sx is decoded while compiling into storage at the narrowest width
+// that holds it: Latin-1 text one byte per code point, other BMP text two,
+// astral text four. The literal must hold the same code points a run-time
+// stdx::string of the same UTF-8 holds, and replace, contains and == must
+// take it as they take any string_view. C++17 uses the GNU literal operator
+// template, C++20 a class-type template parameter; build both:
+//
+//   g++ -std=c++17 -I.. string_literals.cpp -o string_literals
+//   g++ -std=c++20 -I.. string_literals.cpp -o string_literals
+//   cl /std:c++20 /EHsc /I.. string_literals.cpp
+//
+// Exits non-zero and names the failing literal on a mismatch.
+#include <cstdio>
+#include <string>
+#include "../stdxstring.h"
+
+#if !defined(STDX_STRING_LITERALS)
+#error "_sx literals need C++20 or GCC / Clang"
+#endif
+
+using namespace stdx::literals;
+
+static int failures = 0, checked = 0;
+
+static void expect(bool ok, const char* what) {
+    ++checked;
+    if (ok) return;
+    printf("FAIL %s\n", what);
+    ++failures;
+}
+
+// The literal holds what the run-time decoder makes of the same bytes,
+// at the given width.
+static void same_as_runtime(stdx::string_view lit, const std::string& utf8, size_t width, const char* what) {
+    stdx::string s(utf8);
+    expect(lit.width() == width, what);
+    expect(lit.size() == s.size() && lit == s.view() && s == lit && lit.hash() == s.hash(), what);
+}
+
+int main() {
+    // width picked from the widest code point
+    same_as_runtime(""_sx, "", 1, "empty");
+    same_as_runtime("plain ascii"_sx, "plain ascii", 1, "ASCII is Latin-1");
+    same_as_runtime("caf\xC3\xA9 \xC3\xBF"_sx, "caf\xC3\xA9 \xC3\xBF", 1, "U+00FF stays Latin-1");
+    same_as_runtime("\xC4\x80"_sx, "\xC4\x80", 2, "U+0100 is UCS-2");
+    same_as_runtime("\xCE\xB1\xCE\xB2\xCE\xB3 \xE4\xB8\xAD"_sx, "\xCE\xB1\xCE\xB2\xCE\xB3 \xE4\xB8\xAD", 2, "Greek and CJK are UCS-2");
+    same_as_runtime("\xEF\xBF\xBF"_sx, "\xEF\xBF\xBF", 2, "U+FFFF is UCS-2");
+    same_as_runtime("x\xF0\x90\x80\x80"_sx, "x\xF0\x90\x80\x80", 4, "U+10000 is astral");
+    same_as_runtime("\xF0\x9F\x98\x80 \xF4\x8F\xBF\xBF"_sx, "\xF0\x9F\x98\x80 \xF4\x8F\xBF\xBF", 4, "astral");
+    same_as_runtime("a\0b"_sx, std::string("a\0b", 3), 1, "embedded NUL is kept");
+    same_as_runtime("bad \xFF \xE2\x82"_sx, "bad \xFF \xE2\x82", 2, "ill-formed UTF-8 decodes to U+FFFD");
+
+    // code points, not bytes
+    stdx::string_view greek = "\xCE\xB1\xCE\xB2\xCE\xB3"_sx;
+    expect(greek.size() == 3 && greek[0] == 0x3B1 && greek[2] == 0x3B3, "code points of a UCS-2 literal");
+    stdx::string_view emoji = "\xF0\x9F\x98\x80!"_sx;
+    expect(emoji.size() == 2 && emoji[0] == 0x1F600 && emoji[1] == U'!', "code points of an astral literal");
+
+    // members that take a string_view take the literal
+    stdx::string path("C:/dir/caf\xC3\xA9/file");
+    expect(path.replace("/"_sx, "\\"_sx) == "C:\\dir\\caf\xC3\xA9\\file", "replace with literals");
+    expect(stdx::string(path).replace("caf\xC3\xA9"_sx, "\xCE\xB1\xF0\x9F\x98\x80"_sx) == "C:/dir/\xCE\xB1\xF0\x9F\x98\x80/file", "replace widening through literals");
+    expect(path.contains("caf\xC3\xA9"_sx) && !path.contains("\xCE\xB1"_sx) && path.view().contains("dir"_sx), "contains with literals");
+    stdx::string wide("\xE4\xB8\xAD\xE6\x96\x87 text");
+    expect(wide.contains("text"_sx) && wide.contains("\xE4\xB8\xAD"_sx), "contains on UCS-2 text with literals");
+    expect(wide == "\xE4\xB8\xAD\xE6\x96\x87 text"_sx && wide != "\xE4\xB8\xAD"_sx, "== and != with literals");
+    expect("\xE4\xB8\xAD\xE6\x96\x87 text"_sx == wide.view() && "text"_sx != wide.view(), "literal on the left");
+
+    // a stdx::string built from a literal keeps its width
+    stdx::string copied("\xCE\xB1\xCE\xB2"_sx);
+    expect(copied.width() == 2 && copied == "\xCE\xB1\xCE\xB2", "stdx::string from a literal");
+
+#if defined(STDX_STRING_LITERALS_GNU)
+    const char* how = "GNU literal operator template";
+#else
+    const char* how = "class-type template parameter";
+#endif
+    if (!failures) printf("ok   %d literal checks, %s\n", checked, how);
+    return failures ? 1 : 0;
+}
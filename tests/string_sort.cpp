@@ -0,0 +1,103 @@
+// stdx::string::sort orders by packed prefix keys and only looks past
+// them for runs that tie, and compare() takes a memcmp or mismatch-kernel
+// path per width pair. Both must give exactly the code point order of
+// std::u32string. The lists mix all three storage widths, share long
+// prefixes (so keys tie and ranges recurse), and hold U+0000, U+10FFFF,
+// empty strings, duplicates and strings that are prefixes of others; they
+// are sorted in plain and std::pmr vectors.
+//
+//   g++ -std=c++17 -O2 -I.. string_sort.cpp -o string_sort
+//   cl /std:c++17 /O2 /EHsc /I.. string_sort.cpp
+//
+// Exits non-zero and names the first list or pair out of order.
+#include <algorithm>
+#include <cstdio>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+#include "../stdxstring.h"
+
+static std::u32string code_points(const stdx::string& s) {
+    std::u32string out;
+    for (size_t i = 0; i < s.size(); ++i) out += s[i];
+    return out;
+}
+
+static int sign(int v) { return v < 0 ? -1 : v > 0 ? 1 : 0; }
+
+static size_t failures = 0, checked = 0;
+
+template<typename Vector>
+static void check_sort(const std::vector<std::u32string>& list, Vector& strings, const char* kind) {
+    std::vector<std::u32string> want(list);
+    std::sort(want.begin(), want.end());
+    stdx::string::sort(strings);
+    ++checked;
+    for (size_t i = 0; i < want.size(); ++i) {
+        if (code_points(strings[i]) != want[i]) {
+            if (failures++ < 5) printf("FAIL sort of %zu strings (%s): element %zu out of place\n", want.size(), kind, i);
+            return;
+        }
+    }
+}
+
+int main() {
+    // Latin-1, UCS-2 and supplementary code points, with the extremes
+    static const char32_t letters[] = { U'\0', U'a', U'b', U'/', 0xE9, 0xFF, 0x100, 0xFFFF, 0x10000, 0x10FFFF };
+    std::mt19937 rng(7);
+
+    for (int round = 0; round < 3000 && failures == 0; ++round) {
+        // each list draws from a few letters so the widths vary between lists
+        size_t alphabet = 2 + rng() % 4;
+        char32_t pick[5];
+        for (size_t i = 0; i < alphabet; ++i) pick[i] = letters[rng() % std::size(letters)];
+
+        std::vector<std::u32string> prefixes;
+        for (size_t i = 1 + rng() % 4; i--;) {
+            std::u32string p;
+            for (size_t n = rng() % 40; n--;) p += pick[rng() % alphabet];
+            prefixes.push_back(p);
+        }
+
+        std::vector<std::u32string> list;
+        size_t n = round % 10 == 0 ? rng() % 20 : rng() % 600;
+        while (list.size() < n) {
+            std::u32string s = prefixes[rng() % prefixes.size()];
+            for (size_t k = rng() % 12; k--;) s += pick[rng() % alphabet];
+            list.push_back(s);
+            if (rng() % 8 == 0) list.push_back(s);                       // duplicate
+            if (rng() % 8 == 0 && !s.empty()) list.push_back(s.substr(0, rng() % s.size())); // a prefix of it
+        }
+
+        std::vector<stdx::string> plain(list.begin(), list.end());
+        check_sort(list, plain, "std::vector");
+
+        std::pmr::unsynchronized_pool_resource pool;
+        std::pmr::vector<stdx::string> pooled(&pool);
+        for (const auto& s : list) pooled.emplace_back(s);
+        check_sort(list, pooled, "std::pmr::vector");
+        for (const stdx::string& s : pooled) {
+            if (s.get_allocator().resource() != &pool) {
+                if (failures++ < 5) printf("FAIL sort moved a string out of the vector's resource\n");
+                break;
+            }
+        }
+
+        // compare() and the operators on pairs from the same list
+        for (size_t k = 0; k < 50 && list.size() > 1; ++k) {
+            const std::u32string& a = list[rng() % list.size()];
+            const std::u32string& b = list[rng() % list.size()];
+            stdx::string x(a), y(b);
+            int want = sign(a.compare(b));
+            ++checked;
+            if (sign(x.compare(y)) != want || sign(x.view().compare(y.view())) != want ||
+                sign(x.compare(y.view())) != want || (x < y) != (want < 0) || (x == y) != (want == 0)) {
+                if (failures++ < 5) printf("FAIL compare of %zu and %zu code points, expected %d\n", a.size(), b.size(), want);
+            }
+        }
+    }
+
+    if (!failures) printf("ok   %zu sorts and comparisons match std::u32string\n", checked);
+    return failures ? 1 : 0;
+}
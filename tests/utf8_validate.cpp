@@ -0,0 +1,206 @@
+// validate_utf8, inspect_utf8 / count_code_points and decode_utf8 take
+// SIMD paths that work in 16- and 32-byte blocks and carry state across
+// them, and utf8_length_of counts a block at a time in each storage width.
+// They must all agree with a byte-at-a-time reference. Every truncated,
+// overlong, surrogate and above-U+10FFFF sequence (and the valid sequences
+// at the edges of each range) is placed at every offset of buffers that
+// end on either side of the 32- and 64-byte boundaries, between ASCII and
+// between multi-byte text. Build both ways, as the AVX2 validator and the
+// SSE2 one are different code:
+//
+//   g++ -std=c++17 -O2 -I.. utf8_validate.cpp -o utf8_validate
+//   g++ -std=c++17 -O2 -mavx2 -I.. utf8_validate.cpp -o utf8_validate
+//   cl /std:c++17 /O2 /EHsc /I.. utf8_validate.cpp
+//   cl /std:c++17 /O2 /EHsc /arch:AVX2 /I.. utf8_validate.cpp
+//
+// Exits non-zero and prints the first mismatching buffers.
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "../stdxutf.h"
+
+// The reference: Unicode 3.9 Table 3-7 read one byte at a time. An
+// ill-formed sequence becomes one U+FFFD per maximal subpart.
+static std::u32string reference_decode(const std::string& s, bool& valid) {
+    std::u32string out;
+    valid = true;
+    size_t i = 0;
+    while (i < s.size()) {
+        unsigned char b = (unsigned char)s[i];
+        size_t need;
+        unsigned char lo = 0x80, hi = 0xBF;
+        char32_t cp;
+        if (b < 0x80) { out += b; ++i; continue; }
+        else if (b >= 0xC2 && b <= 0xDF) { need = 1; cp = b & 0x1F; }
+        else if (b == 0xE0) { need = 2; cp = 0; lo = 0xA0; }
+        else if (b == 0xED) { need = 2; cp = 0xD; hi = 0x9F; }
+        else if (b >= 0xE1 && b <= 0xEF) { need = 2; cp = b & 0x0F; }
+        else if (b == 0xF0) { need = 3; cp = 0; lo = 0x90; }
+        else if (b == 0xF4) { need = 3; cp = 4; hi = 0x8F; }
+        else if (b >= 0xF1 && b <= 0xF3) { need = 3; cp = b & 0x07; }
+        else { out += stdx::utf::replacement_char; valid = false; ++i; continue; }
+
+        size_t k = 1;
+        for (; k <= need; ++k) {
+            if (i + k >= s.size()) break;
+            unsigned char c = (unsigned char)s[i + k];
+            if (c < lo || c > hi) break;
+            lo = 0x80; hi = 0xBF;
+            cp = (cp << 6) | (c & 0x3F);
+        }
+        if (k <= need) { cp = stdx::utf::replacement_char; valid = false; }
+        out += cp;
+        i += k;
+    }
+    return out;
+}
+
+static size_t reference_utf8_length(const std::u32string& cps) {
+    size_t len = 0;
+    for (char32_t c : cps) {
+        // surrogates and values past U+10FFFF encode as U+FFFD
+        len += c < 0x80 ? 1 : c < 0x800 ? 2 : (c < 0x10000 || c > 0x10FFFF) ? 3 : 4;
+    }
+    return len;
+}
+
+static int width_of(char32_t bits) {
+    return bits > 0xFFFF ? 4 : bits > 0xFF ? 2 : 1;
+}
+
+static std::string hex(const std::string& s) {
+    std::string out;
+    char buf[4];
+    for (unsigned char c : s) {
+        snprintf(buf, sizeof buf, "%02X ", c);
+        out += c >= 0x20 && c < 0x7F ? std::string(1, (char)c) + " " : buf;
+    }
+    return out;
+}
+
+static size_t failures = 0, checked = 0;
+
+static void fail(const char* what, const std::string& s) {
+    if (failures++ < 5) printf("FAIL %s on %zu bytes: %s\n", what, s.size(), hex(s).c_str());
+}
+
+template<typename Unit>
+static void check_length(const std::u32string& cps, const std::string& s) {
+    for (char32_t c : cps) if (c > (char32_t)(Unit)~0u) return;
+    std::vector<Unit> units(cps.begin(), cps.end());
+    size_t want = reference_utf8_length(cps);
+    if (stdx::utf::utf8_length_of(units.data(), units.size()) != want) fail("utf8_length_of", s);
+    std::string enc(want, '\0');
+    if (stdx::utf::encode_utf8(units.data(), units.size(), &enc[0]) != want) fail("encode_utf8 length", s);
+}
+
+static void check(const std::string& s) {
+    ++checked;
+    bool valid;
+    std::u32string want = reference_decode(s, valid);
+    char32_t bits = 0;
+    for (char32_t c : want) bits |= c;
+
+    if (stdx::utf::validate_utf8(s.data(), s.size()) != valid) fail(valid ? "validate_utf8 rejects" : "validate_utf8 accepts", s);
+    stdx::utf::utf_info info = stdx::utf::inspect_utf8(s.data(), s.size());
+    if (info.code_points != want.size()) fail("inspect_utf8 count", s);
+    if (width_of(info.bits) != width_of(bits)) fail("inspect_utf8 width", s);
+    if (stdx::utf::count_code_points(s.data(), s.size()) != want.size()) fail("count_code_points", s);
+
+    std::u32string got(want.size(), U'\0');
+    if (stdx::utf::decode_utf8(s.data(), s.size(), &got[0]) != want.size() || got != want) fail("decode_utf8", s);
+
+    check_length<unsigned char>(want, s);
+    check_length<char16_t>(want, s);
+    check_length<char32_t>(want, s);
+
+    if (valid) {
+        std::string back(reference_utf8_length(want), '\0');
+        stdx::utf::encode_utf8(want.data(), want.size(), &back[0]);
+        if (back != s) fail("encode_utf8 round trip", s);
+    }
+}
+
+int main() {
+    static const char* const sequences[] = {
+        // truncated
+        "\xC2", "\xDF", "\xE0", "\xE0\xA0", "\xE1\x80", "\xED\x9F", "\xEF\xBF", "\xF0", "\xF0\x90", "\xF0\x90\x80",
+        "\xF1\x80\x80", "\xF4\x8F\xBF",
+        // stray continuations
+        "\x80", "\xBF", "\x80\x80", "\xC2\x80\x80", "\xEF\xBF\xBF\xBF", "\xF0\x90\x80\x80\x80",
+        // overlong
+        "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF", "\xF0\x80\x80\x80", "\xF0\x8F\xBF\xBF",
+        // surrogates
+        "\xED\xA0\x80", "\xED\xAF\xBF", "\xED\xB0\x80", "\xED\xBF\xBF", "\xED\xA0\x80\xED\xB0\x80",
+        // above U+10FFFF and bytes that never appear
+        "\xF4\x90\x80\x80", "\xF4\xBF\xBF\xBF", "\xF5\x80\x80\x80", "\xF7\xBF\xBF\xBF", "\xF8\x88\x80\x80\x80", "\xFE", "\xFF",
+        // a lead cut off by another lead or by ASCII
+        "\xC2\xC2\x80", "\xE1\x80\xE1\x80\x80", "\xF1\x80\x80\x41",
+        // valid, at the edges of each range
+        "\xC2\x80", "\xC3\xBF", "\xC4\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF", "\xEE\x80\x80", "\xEF\xBF\xBD",
+        "\xEF\xBF\xBF", "\xF0\x90\x80\x80", "\xF1\x80\x80\x80", "\xF4\x8F\xBF\xBF",
+    };
+    // text the sequences are embedded in, whole characters at a time
+    static const char* const fillers[] = { "a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "a\xC3\xA9" };
+    static const size_t lengths[] = { 1, 2, 3, 4, 15, 16, 17, 31, 32, 33, 34, 35, 63, 64, 65, 66, 67, 95, 96, 97, 127, 128, 129 };
+
+    auto fill = [](std::string& out, const std::string& filler, size_t n) {
+        size_t stop = out.size() + n;
+        while (out.size() + filler.size() <= stop) out += filler;
+        while (out.size() < stop) out += 'x';
+    };
+
+    for (const char* seq : sequences) {
+        std::string bad(seq);
+        for (const char* f : fillers) {
+            for (size_t n : lengths) {
+                if (n < bad.size()) continue;
+                for (size_t at = 0; at + bad.size() <= n; ++at) {
+                    std::string s;
+                    fill(s, f, at);
+                    s += bad;
+                    fill(s, f, n - s.size());
+                    check(s);
+                }
+            }
+        }
+    }
+
+    // two sequences at once, so errors in one block are not hidden by another
+    std::mt19937 rng(99);
+    for (int round = 0; round < 200000 && failures == 0; ++round) {
+        std::string s;
+        size_t n = rng() % 200;
+        while (s.size() < n) {
+            switch (rng() % 4) {
+            case 0: s += sequences[rng() % std::size(sequences)]; break;
+            case 1: fill(s, fillers[rng() % std::size(fillers)], rng() % 40); break;
+            default: s += (char)(rng() % 256); break;
+            }
+        }
+        check(s);
+    }
+
+    // code points that cannot be encoded, in every storage width
+    static const char32_t awkward[] = { 0, 0x7F, 0x80, 0xFF, 0x100, 0x7FF, 0x800, 0xD800, 0xDBFF, 0xDC00, 0xDFFF,
+        0xFFFD, 0xFFFF, 0x10000, 0x10FFFF, 0x110000, 0x7FFFFFFF, 0xFFFFFFFF };
+    for (int round = 0; round < 20000 && failures == 0; ++round) {
+        std::u32string cps;
+        size_t n = rng() % 80;
+        char32_t top = round % 3 == 0 ? 0xFF : round % 3 == 1 ? 0xFFFF : 0xFFFFFFFF;
+        while (cps.size() < n) {
+            char32_t c = rng() % 2 ? awkward[rng() % std::size(awkward)] : (char32_t)(rng() % 0x80);
+            if (c <= top) cps += c;
+        }
+        std::string name = "code points";
+        ++checked;
+        if (top == 0xFF) check_length<unsigned char>(cps, name);
+        if (top <= 0xFFFF) check_length<char16_t>(cps, name);
+        check_length<char32_t>(cps, name);
+    }
+
+    if (!failures) printf("ok   %zu buffers match the reference\n", checked);
+    return failures ? 1 : 0;
+}
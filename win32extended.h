@@ -47,7 +47,15 @@
 #include <filesystem>
 #endif
 
+#include "stdxutf.h"
+#include "stdxsearch.h"
+#include "stdxcase.h"
+#include "stdxhash.h"
+#include "stdxscan.h"
 #include "stdxstring.h"
+#include "stdxatom.h"
+#include "stdxglob.h"
+#include "stdxshared.h"
 #include "stdxstream.h"
 #include "stdxfile.h"
 #include "stdxout.h"
@@ -257,17 +265,49 @@ namespace stdx {
         }
 #endif
 
+        // Caseless substring match on the executable name ("notepad",
+        // "notepad.exe"); a '.' is taken as itself. A pattern with any
+        // other regex syntax is decoded from UTF-8 and searched as an icase
+        // regex, compiled on every call: callers that poll should build a
+        // stdx::glob once and use IsRunning(const stdx::glob&) instead,
+        // which also matches whole names with wildcards, dots included.
         inline bool IsRunning(const std::string& patt) {
             HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
             if (snap == INVALID_HANDLE_VALUE) return false;
             PROCESSENTRY32W pe{ sizeof(pe) };
 
-            std::wregex r(std::wstring(patt.begin(), patt.end()), std::regex_constants::icase);
+            // the literal path folds as it compares, no regex and no copy per entry
+            bool literal = patt.find_first_of("\\^$|?*+()[]{}") == std::string::npos;
+            stdx::string needle = stdx::string(patt).to_folded();
+            std::wregex r;
+            if (!literal) r.assign(std::wstring(stdx::string(patt)), std::regex_constants::icase);
 
             bool found = false;
             if (Process32FirstW(snap, &pe)) {
                 do {
-                    if (std::regex_search(pe.szExeFile, r)) { found = true; break; }
+                    if (literal) {
+                        size_t n = wcslen(pe.szExeFile);
+                        for (size_t i = 0; i <= n && !found; ++i) found = MatchFolded(pe.szExeFile, n, i, needle.view()) != npos;
+                    }
+                    else found = std::regex_search(pe.szExeFile, r);
+                } while (!found && Process32NextW(snap, &pe));
+            }
+
+            CloseHandle(snap);
+            return found;
+        }
+
+        // Whole-name wildcard match ("chrome*.exe", "svc?ost.exe"); build the
+        // glob once and reuse it when polling, no regex is involved.
+        inline bool IsRunning(const stdx::glob& pattern) {
+            HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+            if (snap == INVALID_HANDLE_VALUE) return false;
+            PROCESSENTRY32W pe{ sizeof(pe) };
+
+            bool found = false;
+            if (Process32FirstW(snap, &pe)) {
+                do {
+                    if (pattern.matches(pe.szExeFile)) { found = true; break; }
                 } while (Process32NextW(snap, &pe));
             }
 
@@ -280,12 +320,13 @@ namespace stdx {
             if (snap == INVALID_HANDLE_VALUE) return false;
             PROCESSENTRY32W pe{ sizeof(pe) };
 
-            std::wstring wexe(exe.begin(), exe.end());
+            stdx::string name = stdx::string(exe).to_folded();
 
             bool found = false;
             if (Process32FirstW(snap, &pe)) {
                 do {
-                    if (_wcsicmp(pe.szExeFile, wexe.c_str()) == 0) { found = true; break; }
+                    size_t n = wcslen(pe.szExeFile);
+                    if (MatchFolded(pe.szExeFile, n, 0, name.view()) == n) { found = true; break; }
                 } while (Process32NextW(snap, &pe));
             }
 
@@ -293,5 +334,22 @@ namespace stdx {
             return found;
         }
 
+    private:
+        static constexpr size_t npos = (size_t)-1;
+
+        // Matches folded code points against the UTF-16 text at [i, n),
+        // joining surrogate pairs and folding as it reads. Returns the
+        // index just past the match, or npos.
+        inline static size_t MatchFolded(const wchar_t* text, size_t n, size_t i, stdx::string_view folded) {
+            for (size_t k = 0; k < folded.size(); ++k) {
+                if (i >= n) return npos;
+                char32_t cp = (char16_t)text[i++];
+                if (cp >= 0xD800 && cp <= 0xDBFF && i < n && (char16_t)text[i] >= 0xDC00 && (char16_t)text[i] <= 0xDFFF) {
+                    cp = 0x10000 + (((cp - 0xD800) << 10) | ((char16_t)text[i++] - 0xDC00));
+                }
+                if (stdx::unicode::fold(cp) != folded[k]) return npos;
+            }
+            return i;
+        }
     };
 } // namespace stdx